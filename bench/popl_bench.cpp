@@ -0,0 +1,375 @@
+// popl_bench: runs each PopL workload in bench/workloads through Driver::Run
+// in a child process of its own and reports median/p95 wall time, heap
+// allocations and peak RSS, optionally comparing against (or writing) a
+// baseline JSON file.
+// --allocator=system allocates from the global heap instead of the
+// interpreter's object pool, to compare the two.
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <new>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "popl/diagnostics.hpp"
+#include "popl/driver.hpp"
+#include "popl/runtime/object_pool.hpp"
+#include "popl/utils.hpp"
+
+#ifndef POPL_BENCH_DIR
+#define POPL_BENCH_DIR "bench/workloads"
+#endif
+
+// ---------------- Allocation counting ----------------
+
+static std::atomic<std::size_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void  operator delete(void* p) noexcept { std::free(p); }
+void  operator delete[](void* p) noexcept { std::free(p); }
+void  operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void  operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// ---------------- Baseline JSON ----------------
+
+struct Result {
+    double      median_ms{};
+    double      p95_ms{};
+    std::size_t allocations{};
+    long        peak_rss_kb{};
+};
+
+using Baseline = std::map<std::string, Result>;
+
+// Reader for the flat {"workloads": {"<name>": {"<key>": <number>}}} layout
+// written by WriteBaseline(); anything else is rejected.
+class BaselineReader {
+   public:
+    explicit BaselineReader(std::string text) : m_text(std::move(text)) {}
+
+    Baseline Read() {
+        Baseline baseline;
+        Expect('{');
+        if (ReadString() != "workloads") throw Fail("expected \"workloads\"");
+        Expect(':');
+        Expect('{');
+        while (!Consume('}')) {
+            std::string name = ReadString();
+            Expect(':');
+            Expect('{');
+            Result result;
+            while (!Consume('}')) {
+                std::string key = ReadString();
+                Expect(':');
+                double value = ReadNumber();
+                if (key == "median_ms") result.median_ms = value;
+                if (key == "p95_ms") result.p95_ms = value;
+                if (key == "allocations")
+                    result.allocations = static_cast<std::size_t>(value);
+                if (key == "peak_rss_kb")
+                    result.peak_rss_kb = static_cast<long>(value);
+                Consume(',');
+            }
+            baseline.emplace(std::move(name), result);
+            Consume(',');
+        }
+        Expect('}');
+        return baseline;
+    }
+
+   private:
+    std::runtime_error Fail(std::string_view what) const {
+        return std::runtime_error(
+            std::format("baseline: {} at offset {}", what, m_pos));
+    }
+    void SkipSpace() {
+        while (m_pos < m_text.size() &&
+               std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+            ++m_pos;
+    }
+    bool Consume(char c) {
+        SkipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+    void Expect(char c) {
+        if (!Consume(c)) throw Fail(std::format("expected '{}'", c));
+    }
+    std::string ReadString() {
+        Expect('"');
+        auto end = m_text.find('"', m_pos);
+        if (end == std::string::npos) throw Fail("unterminated string");
+        std::string value = m_text.substr(m_pos, end - m_pos);
+        m_pos             = end + 1;
+        return value;
+    }
+    double ReadNumber() {
+        SkipSpace();
+        const char* begin = m_text.c_str() + m_pos;
+        char*       end   = nullptr;
+        double      value = std::strtod(begin, &end);
+        if (end == begin) throw Fail("expected number");
+        m_pos += static_cast<std::size_t>(end - begin);
+        return value;
+    }
+
+   private:
+    std::string m_text;
+    std::size_t m_pos{};
+};
+
+static void WriteBaseline(const std::string& path, const Baseline& results) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to open '" + path + "'");
+    out << "{\n  \"workloads\": {\n";
+    std::size_t i = 0;
+    for (const auto& [name, r] : results) {
+        out << std::format(
+            "    \"{}\": {{\"median_ms\": {:.3f}, \"p95_ms\": {:.3f}, "
+            "\"allocations\": {}, \"peak_rss_kb\": {}}}{}\n",
+            name, r.median_ms, r.p95_ms, r.allocations, r.peak_rss_kb,
+            ++i < results.size() ? "," : "");
+    }
+    out << "  }\n}\n";
+}
+
+// ---------------- Running ----------------
+
+using Allocator = popl::runtime::ObjectPool::Strategy;
+
+struct Options {
+    int         warmup{1};
+    int         repetitions{5};
+    double      threshold_pct{10.0};
+    std::string workload_dir{POPL_BENCH_DIR};
+    std::string baseline_path{};
+    std::string write_baseline_path{};
+    std::string filter{};
+    Allocator   allocator{Allocator::POOLED};
+};
+
+// Sends the scripts' own print() output to /dev/null while timing
+class StdoutSilencer {
+   public:
+    StdoutSilencer() {
+        std::fflush(stdout);
+        m_saved     = dup(STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+    }
+    ~StdoutSilencer() {
+        std::fflush(stdout);
+        dup2(m_saved, STDOUT_FILENO);
+        close(m_saved);
+    }
+
+   private:
+    int m_saved;
+};
+
+static long PeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double Percentile(std::vector<double> samples, double pct) {
+    std::sort(samples.begin(), samples.end());
+    double rank  = pct / 100.0 * static_cast<double>(samples.size() - 1);
+    auto   index = static_cast<std::size_t>(rank + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+static bool RunWorkload(popl::Driver& driver, const std::string& source,
+                        const Options& options, Result& result) {
+    std::vector<double> samples;
+    std::size_t         allocations = 0;
+    for (int i = 0; i < options.warmup + options.repetitions; ++i) {
+        std::size_t allocs_before = g_allocations.load();
+        auto        start         = std::chrono::steady_clock::now();
+        {
+            StdoutSilencer silence;
+            driver.Run(source);
+        }
+        auto end = std::chrono::steady_clock::now();
+        const auto& diagnostics = driver.GetDiagnostics();
+        if (diagnostics.HadError() || diagnostics.HadRunTimeError())
+            return false;
+        if (i < options.warmup) continue;
+        samples.push_back(
+            std::chrono::duration<double, std::milli>(end - start).count());
+        allocations = g_allocations.load() - allocs_before;
+    }
+    result.median_ms   = Percentile(samples, 50.0);
+    result.p95_ms      = Percentile(samples, 95.0);
+    result.allocations = allocations;
+    result.peak_rss_kb = PeakRssKb();
+    return true;
+}
+
+// Runs the workload in a forked child: ru_maxrss is a high-water mark for the
+// whole process, so in-process it would only ever report the largest
+// workload so far. The parent runs no scripts, so every child starts from the
+// same footprint.
+static bool RunIsolated(const std::string& source, const Options& options,
+                        Result& result) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        popl::Driver driver;
+        driver.GetInterpreter().SetAllocationStrategy(options.allocator);
+        Result measured;
+        bool   ok = RunWorkload(driver, source, options, measured) &&
+                  write(fds[1], &measured, sizeof measured) ==
+                      static_cast<ssize_t>(sizeof measured);
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    // A Result is smaller than PIPE_BUF, so it arrives in one piece
+    ssize_t received = read(fds[0], &result, sizeof result);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return received == static_cast<ssize_t>(sizeof result) &&
+           WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void PrintUsage() {
+    std::println(
+        "Usage: popl_bench [--warmup=N] [--reps=N] [--filter=substr]\n"
+        "                  [--baseline=file.json] "
+        "[--write-baseline=file.json]\n"
+        "                  [--threshold=pct] [--allocator=pooled|system]\n"
+        "                  [workload_dir]");
+}
+
+static bool ParseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        auto             value = [&](std::string_view prefix) {
+            return std::string{arg.substr(prefix.size())};
+        };
+        if (arg.starts_with("--warmup="))
+            options.warmup = std::stoi(value("--warmup="));
+        else if (arg.starts_with("--reps="))
+            options.repetitions = std::max(1, std::stoi(value("--reps=")));
+        else if (arg.starts_with("--filter="))
+            options.filter = value("--filter=");
+        else if (arg.starts_with("--baseline="))
+            options.baseline_path = value("--baseline=");
+        else if (arg.starts_with("--write-baseline="))
+            options.write_baseline_path = value("--write-baseline=");
+        else if (arg.starts_with("--threshold="))
+            options.threshold_pct = std::stod(value("--threshold="));
+        else if (arg == "--allocator=pooled")
+            options.allocator = Allocator::POOLED;
+        else if (arg == "--allocator=system")
+            options.allocator = Allocator::SYSTEM;
+        else if (arg.starts_with("--"))
+            return false;
+        else
+            options.workload_dir = arg;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, options)) {
+        PrintUsage();
+        return 64;
+    }
+
+    std::vector<std::filesystem::path> workloads;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(options.workload_dir)) {
+        if (entry.path().extension() != ".popl") continue;
+        if (!options.filter.empty() &&
+            entry.path().stem().string().find(options.filter) ==
+                std::string::npos)
+            continue;
+        workloads.push_back(entry.path());
+    }
+    std::sort(workloads.begin(), workloads.end());
+
+    Baseline baseline;
+    if (!options.baseline_path.empty()) {
+        BaselineReader reader{utils::ReadFile(options.baseline_path)};
+        baseline = reader.Read();
+    }
+
+    std::println("{:<18} {:>11} {:>11} {:>12} {:>12} {:>9}", "workload",
+                 "median ms", "p95 ms", "allocations", "peak rss kb",
+                 "vs base");
+
+    Baseline results;
+    int      regressions = 0;
+    for (const auto& path : workloads) {
+        std::string name   = path.stem().string();
+        std::string source = utils::ReadFile(path.string());
+        Result      result;
+        if (!RunIsolated(source, options, result)) {
+            std::println("{:<18} failed", name);
+            return 1;
+        }
+        results.emplace(name, result);
+
+        std::string delta = "-";
+        if (auto it = baseline.find(name); it != baseline.end()) {
+            double change =
+                (result.median_ms - it->second.median_ms) /
+                it->second.median_ms * 100.0;
+            delta = std::format("{:+.1f}%", change);
+            if (change > options.threshold_pct) {
+                delta += " !";
+                ++regressions;
+            }
+        }
+        std::println("{:<18} {:>11.3f} {:>11.3f} {:>12} {:>12} {:>9}", name,
+                     result.median_ms, result.p95_ms, result.allocations,
+                     result.peak_rss_kb, delta);
+    }
+
+    if (!options.write_baseline_path.empty())
+        WriteBaseline(options.write_baseline_path, results);
+
+    if (regressions > 0) {
+        std::println("{} workload(s) regressed by more than {:.1f}%",
+                     regressions, options.threshold_pct);
+        return 1;
+    }
+    return 0;
+}
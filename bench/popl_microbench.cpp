@@ -0,0 +1,283 @@
+// popl_microbench: front-end throughput on synthetic sources.
+// Measures Lexer::ScanTokens (MB/s, tokens/s), Parser::Parse (nodes/s) and
+// Resolver::Resolve (nodes/s) separately from execution, for generated
+// programs with many functions, deep nesting or long expressions.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <functional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "popl/diagnostics.hpp"
+#include "popl/lexer/lexer.hpp"
+#include "popl/syntax/grammar/parser.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
+#include "popl/syntax/visitors/resolver.hpp"
+
+using namespace popl;
+
+// ---------------- Source generators ----------------
+
+struct Shape {
+    std::string_view                         name;
+    std::function<std::string(std::size_t)> generate;  // arg: target bytes
+};
+
+static std::string ManyFunctions(std::size_t target_bytes) {
+    std::string out;
+    for (std::size_t i = 0; out.size() < target_bytes; ++i) {
+        out += std::format(
+            "fun f{}(a, b) {{\n"
+            "    var c = a * {} + b;\n"
+            "    if (c > b) return c - a; else return c + a;\n"
+            "}}\n"
+            "f{}(1, 2);\n",
+            i, i, i);
+    }
+    return out;
+}
+
+static std::string DeepNesting(std::size_t target_bytes, int depth) {
+    std::string out{"var x = 0;\n"};
+    while (out.size() < target_bytes) {
+        for (int d = 0; d < depth; ++d) out += "if (x < 1) {\n";
+        out += "x = x + 1;\n";
+        for (int d = 0; d < depth; ++d) out += "}\n";
+    }
+    return out;
+}
+
+static std::string LongExpressions(std::size_t target_bytes, int terms) {
+    std::string out{"var y = 1;\n"};
+    for (std::size_t i = 0; out.size() < target_bytes; ++i) {
+        out += std::format("var e{} = y", i);
+        for (int t = 0; t < terms; ++t) {
+            static constexpr std::string_view ops[] = {" + ", " * ", " - ",
+                                                       " / "};
+            out += ops[t % 4];
+            out += t % 3 == 0 ? std::format("(y + {})", t) : std::to_string(t);
+        }
+        out += ";\n";
+    }
+    return out;
+}
+
+// ---------------- AST node counting ----------------
+
+struct NodeCounter {
+    std::size_t count{};
+
+    void Count(const Expr& expr) {
+        ++count;
+        visitExprWithArgs(expr, *this);
+    }
+    void Count(const Stmt& stmt) {
+        ++count;
+        visitStmtWithArgs(stmt, *this);
+    }
+    void Count(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+        for (const auto& stmt : stmts)
+            if (stmt) Count(*stmt);
+    }
+    void Count(const std::unique_ptr<Expr>& expr) {
+        if (expr) Count(*expr);
+    }
+    void Count(const std::unique_ptr<Stmt>& stmt) {
+        if (stmt) Count(*stmt);
+    }
+
+    // Expressions
+    void operator()(const NilExpr&) {}
+    void operator()(const LiteralExpr&) {}
+    void operator()(const VariableExpr&) {}
+    void operator()(const ThisExpr&) {}
+    void operator()(const BinaryExpr& e) {
+        Count(e.left);
+        Count(e.right);
+    }
+    void operator()(const LogicalExpr& e) {
+        Count(e.left);
+        Count(e.right);
+    }
+    void operator()(const TernaryExpr& e) {
+        Count(e.condition);
+        Count(e.thenBranch);
+        Count(e.elseBranch);
+    }
+    void operator()(const GroupingExpr& e) { Count(e.expression); }
+    void operator()(const UnaryExpr& e) { Count(e.right); }
+    void operator()(const CallExpr& e) {
+        Count(e.callee);
+        for (const auto& arg : e.arguments) Count(arg);
+    }
+    void operator()(const FunctionExpr& e) { Count(e.body); }
+    void operator()(const GetExpr& e) { Count(e.object); }
+    void operator()(const SetExpr& e) {
+        Count(e.object);
+        Count(e.value);
+    }
+    void operator()(const AssignExpr& e) { Count(e.value); }
+    void operator()(const ArrayExpr& e) {
+        for (const auto& element : e.elements) Count(element);
+    }
+    void operator()(const IndexExpr& e) {
+        Count(e.object);
+        Count(e.index);
+    }
+    void operator()(const MapExpr& e) {
+        for (const auto& key : e.keys) Count(key);
+        for (const auto& value : e.values) Count(value);
+    }
+    void operator()(const IndexSetExpr& e) {
+        Count(e.object);
+        Count(e.index);
+        Count(e.value);
+    }
+    void operator()(const IncrementExpr&) {}
+    void operator()(const CompareExpr&) {}
+    void operator()(const ThisGetExpr&) {}
+    void operator()(const InvariantExpr& e) { Count(e.expression); }
+
+    // Statements
+    void operator()(const NilStmt&) {}
+    void operator()(const BreakStmt&) {}
+    void operator()(const ContinueStmt&) {}
+    void operator()(const BlockStmt& s) { Count(s.statements); }
+    void operator()(const ExpressionStmt& s) { Count(s.expression); }
+    void operator()(const VarStmt& s) { Count(s.initializer); }
+    void operator()(const IfStmt& s) {
+        Count(s.condition);
+        Count(s.thenBranch);
+        Count(s.elseBranch);
+    }
+    void operator()(const WhileStmt& s) {
+        Count(s.condition);
+        Count(s.body);
+    }
+    void operator()(const ReturnStmt& s) { Count(s.value); }
+    void operator()(const FunctionStmt& s) { Count(s.func->body); }
+    void operator()(const ClassStmt& s) {
+        for (const auto& method : s.methods) Count(method->func->body);
+    }
+};
+
+// ---------------- Measurement ----------------
+
+struct Options {
+    std::size_t      size_kb{256};
+    int              repetitions{5};
+    int              depth{64};
+    int              terms{64};
+    std::string_view shape{"all"};
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double Seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+static double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static bool Measure(std::string_view name, const std::string& source,
+                    const Options& options) {
+    std::vector<double> lex, parse, resolve;
+    std::size_t         tokens_count = 0, nodes = 0;
+
+    for (int rep = 0; rep < options.repetitions; ++rep) {
+        Interpreter  interpreter;
+        Diagnostics& diagnostics = interpreter.GetDiagnostics();
+        Lexer        lexer{source, diagnostics};
+        auto         start  = Clock::now();
+        auto         tokens = lexer.ScanTokens();
+        lex.push_back(Seconds(Clock::now() - start));
+        tokens_count = tokens.size();
+
+        Parser parser{std::move(tokens), diagnostics};
+        start           = Clock::now();
+        auto statements = parser.Parse();
+        parse.push_back(Seconds(Clock::now() - start));
+
+        Resolver resolver{interpreter};
+        start = Clock::now();
+        resolver.Resolve(statements);
+        resolve.push_back(Seconds(Clock::now() - start));
+
+        if (diagnostics.HadError()) {
+            std::println(stderr, "{}: generated source failed to compile",
+                         name);
+            return false;
+        }
+        NodeCounter counter;
+        counter.Count(statements);
+        nodes = counter.count;
+    }
+
+    double mb        = static_cast<double>(source.size()) / (1024.0 * 1024.0);
+    double lex_s     = Median(lex);
+    double parse_s   = Median(parse);
+    double resolve_s = Median(resolve);
+    std::println("{:<12} {:>9} {:>9} {:>10.1f} {:>12.0f} {:>12.0f} {:>12.0f}",
+                 name, source.size() / 1024, nodes, mb / lex_s,
+                 static_cast<double>(tokens_count) / lex_s,
+                 static_cast<double>(nodes) / parse_s,
+                 static_cast<double>(nodes) / resolve_s);
+    return true;
+}
+
+static void PrintUsage() {
+    std::println(
+        "Usage: popl_microbench [--size-kb=N] [--reps=N] [--depth=N] "
+        "[--terms=N]\n"
+        "                       [--shape=all|functions|nesting|expressions]");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        auto             number = [&](std::string_view prefix) {
+            return std::stoi(std::string{arg.substr(prefix.size())});
+        };
+        if (arg.starts_with("--size-kb="))
+            options.size_kb = static_cast<std::size_t>(number("--size-kb="));
+        else if (arg.starts_with("--reps="))
+            options.repetitions = std::max(1, number("--reps="));
+        else if (arg.starts_with("--depth="))
+            options.depth = std::max(1, number("--depth="));
+        else if (arg.starts_with("--terms="))
+            options.terms = std::max(1, number("--terms="));
+        else if (arg.starts_with("--shape="))
+            options.shape = arg.substr(std::string_view{"--shape="}.size());
+        else {
+            PrintUsage();
+            return 64;
+        }
+    }
+
+    const std::size_t bytes = options.size_kb * 1024;
+    const Shape       shapes[]{
+        {"functions", [](std::size_t n) { return ManyFunctions(n); }},
+        {"nesting",
+         [&](std::size_t n) { return DeepNesting(n, options.depth); }},
+        {"expressions",
+         [&](std::size_t n) { return LongExpressions(n, options.terms); }},
+    };
+
+    std::println("{:<12} {:>9} {:>9} {:>10} {:>12} {:>12} {:>12}", "shape",
+                 "size kb", "nodes", "lex MB/s", "lex tok/s", "parse nod/s",
+                 "resolve n/s");
+    for (const auto& shape : shapes) {
+        if (options.shape != "all" && options.shape != shape.name) continue;
+        if (!Measure(shape.name, shape.generate(bytes), options)) return 1;
+    }
+    return 0;
+}
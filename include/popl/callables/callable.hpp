@@ -1,7 +1,9 @@
 #pragma once
 
+#include <span>
 #include <string>
-#include <vector>
+
+#include "popl/runtime/object_pool.hpp"
 
 namespace popl {
 
@@ -10,17 +12,23 @@ class PopLObject;
 
 namespace callable {
 
-class PoplCallable {
+/// Created through runtime::MakeRef() and allocated from the current pool
+class PoplCallable : public runtime::RefCounted, public runtime::Pooled {
    public:
     virtual ~PoplCallable() = default;
 
     virtual int GetArity() const = 0;
 
-    virtual popl::PopLObject Call(
-        popl::Interpreter&                   interpreter,
-        const std::vector<popl::PopLObject>& args) = 0;
+    // `args` holds exactly GetArity() values and is only valid during the
+    // call
+    virtual popl::PopLObject Call(popl::Interpreter&                interpreter,
+                                  std::span<const popl::PopLObject> args) = 0;
 
     virtual std::string ToString() const = 0;
+
+    // True when calls have no side effects and depend only on the arguments,
+    // so that a call with unchanged arguments may be skipped
+    virtual bool IsPure() const { return false; }
 };
 
 }  // namespace callable
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "popl/callables/native_functions.hpp"
+#include "popl/literal.hpp"
+
+namespace popl::callable {
+
+/*
+ * Typed natives: a plain C++ function such as `double(double, double)` is
+ * turned into a NativeFunction::FnType at compile time. The generated thunk
+ * checks each argument's type, unwraps it and wraps the result, so the body
+ * deals in C++ types only. An optional leading `Interpreter&` parameter is
+ * passed through and does not count towards the arity.
+ */
+
+// How a C++ parameter type is read from a PopL value
+template <typename T>
+struct NativeArgument;
+
+template <>
+struct NativeArgument<double> {
+    static constexpr std::string_view kName = "a number";
+    static bool   Check(const PopLObject& value) { return value.isNumber(); }
+    static double Get(const PopLObject& value) { return value.asNumber(); }
+};
+template <>
+struct NativeArgument<bool> {
+    static constexpr std::string_view kName = "a boolean";
+    static bool Check(const PopLObject& value) { return value.isBool(); }
+    static bool Get(const PopLObject& value) { return value.asBool(); }
+};
+// Views into the argument, valid for the duration of the call
+template <>
+struct NativeArgument<std::string_view> {
+    static constexpr std::string_view kName = "a string";
+    static bool Check(const PopLObject& value) { return value.isString(); }
+    static std::string_view Get(const PopLObject& value) {
+        return value.asString();
+    }
+};
+template <>
+struct NativeArgument<const std::string&> : NativeArgument<std::string_view> {
+    static const std::string& Get(const PopLObject& value) {
+        return value.asString();
+    }
+};
+// Any value, unchecked
+template <>
+struct NativeArgument<const PopLObject&> {
+    static constexpr std::string_view kName = "a value";
+    static bool Check(const PopLObject&) { return true; }
+    static const PopLObject& Get(const PopLObject& value) { return value; }
+};
+
+template <>
+struct NativeArgument<PopLObject> : NativeArgument<const PopLObject&> {};
+
+// Shared objects, taken by value
+template <typename Ptr, bool (PopLObject::*Is)() const,
+          const Ptr& (PopLObject::*As)() const>
+struct NativePointerArgument {
+    static bool       Check(const PopLObject& value) { return (value.*Is)(); }
+    static const Ptr& Get(const PopLObject& value) { return (value.*As)(); }
+};
+template <>
+struct NativeArgument<PopLObject::CallablePtr>
+    : NativePointerArgument<PopLObject::CallablePtr, &PopLObject::isCallable,
+                            &PopLObject::asCallable> {
+    static constexpr std::string_view kName = "a function";
+};
+template <>
+struct NativeArgument<PopLObject::InstancePtr>
+    : NativePointerArgument<PopLObject::InstancePtr, &PopLObject::isInstance,
+                            &PopLObject::asInstance> {
+    static constexpr std::string_view kName = "an instance";
+};
+template <>
+struct NativeArgument<PopLObject::ArrayPtr>
+    : NativePointerArgument<PopLObject::ArrayPtr, &PopLObject::isArray,
+                            &PopLObject::asArray> {
+    static constexpr std::string_view kName = "an array";
+};
+template <>
+struct NativeArgument<PopLObject::MapPtr>
+    : NativePointerArgument<PopLObject::MapPtr, &PopLObject::isMap,
+                            &PopLObject::asMap> {
+    static constexpr std::string_view kName = "a map";
+};
+template <>
+struct NativeArgument<PopLObject::Float64ArrayPtr>
+    : NativePointerArgument<PopLObject::Float64ArrayPtr,
+                            &PopLObject::isFloat64Array,
+                            &PopLObject::asFloat64Array> {
+    static constexpr std::string_view kName = "a Float64Array";
+};
+
+// How a C++ return value becomes a PopL value; void returns nil and other
+// arithmetic types become numbers
+template <typename R>
+PopLObject WrapNativeResult(R&& result) {
+    using T = std::remove_cvref_t<R>;
+    if constexpr (std::is_same_v<T, PopLObject>)
+        return std::forward<R>(result);
+    else if constexpr (std::is_same_v<T, bool>)
+        return PopLObject(result);
+    else if constexpr (std::is_arithmetic_v<T>)
+        return PopLObject(static_cast<double>(result));
+    else if constexpr (std::is_same_v<T, std::string>)
+        return PopLObject(std::forward<R>(result));
+    else if constexpr (std::is_convertible_v<T, std::string_view>)
+        return PopLObject(std::string(result));
+    else
+        return PopLObject{std::forward<R>(result)};
+}
+
+template <typename Signature>
+struct NativeSignature;
+
+template <typename R, typename... Args>
+struct NativeSignature<R (*)(Args...)> {
+    using Result     = R;
+    using Parameters = std::tuple<Args...>;
+    static constexpr bool kTakesInterpreter = false;
+};
+template <typename R, typename... Args>
+struct NativeSignature<R (*)(Interpreter&, Args...)> {
+    using Result     = R;
+    using Parameters = std::tuple<Args...>;
+    static constexpr bool kTakesInterpreter = true;
+};
+
+template <auto Fn>
+using NativeSignatureOf = NativeSignature<std::decay_t<decltype(Fn)>>;
+
+// Arity of a typed native, not counting a leading Interpreter&
+template <auto Fn>
+constexpr int kNativeArity =
+    std::tuple_size_v<typename NativeSignatureOf<Fn>::Parameters>;
+
+template <auto Fn>
+PopLObject NativeThunk(Interpreter&                interpreter,
+                       std::span<const PopLObject> args) {
+    using Signature  = NativeSignatureOf<Fn>;
+    using Parameters = typename Signature::Parameters;
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (
+            [&] {
+                using Argument =
+                    NativeArgument<std::tuple_element_t<I, Parameters>>;
+                if (!Argument::Check(args[I]))
+                    throw NativeArgumentError{I, Argument::kName};
+            }(),
+            ...);
+        auto call = [&] {
+            if constexpr (Signature::kTakesInterpreter)
+                return Fn(interpreter,
+                          NativeArgument<std::tuple_element_t<I, Parameters>>::
+                              Get(args[I])...);
+            else
+                return Fn(NativeArgument<std::tuple_element_t<I, Parameters>>::
+                              Get(args[I])...);
+        };
+        if constexpr (std::is_void_v<typename Signature::Result>) {
+            call();
+            return PopLObject{NilValue{}};
+        } else {
+            return WrapNativeResult(call());
+        }
+    }(std::make_index_sequence<std::tuple_size_v<Parameters>>{});
+}
+
+// A NativeFunction calling `Fn` through its generated thunk
+template <auto Fn>
+runtime::Ref<NativeFunction> MakeNative(std::string name, bool pure = false) {
+    return runtime::MakeRef<NativeFunction>(std::move(name), kNativeArity<Fn>,
+                                            &NativeThunk<Fn>, pure);
+}
+
+}  // namespace popl::callable
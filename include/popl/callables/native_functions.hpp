@@ -1,8 +1,9 @@
 #pragma once
 
-#include <functional>
+#include <cstddef>
+#include <span>
 #include <string>
-#include <vector>
+#include <string_view>
 
 #include "callable.hpp"
 
@@ -13,17 +14,25 @@ class PopLObject;
 
 namespace callable {
 
+/// Thrown by a native when argument `index` is not `expected` (e.g. "a
+/// number"); NativeFunction reports it as a runtime error naming the native.
+struct NativeArgumentError {
+    std::size_t      index;
+    std::string_view expected;
+};
+
 class NativeFunction : public PoplCallable {
    public:
-    using FnType =
-        std::function<PopLObject(Interpreter&, const std::vector<PopLObject>&)>;
+    // A plain function pointer; see native_binding.hpp for typed natives
+    using FnType = PopLObject (*)(Interpreter&, std::span<const PopLObject>);
 
-    NativeFunction(std::string name, int arity, FnType fn);
+    NativeFunction(std::string name, int arity, FnType fn, bool pure = false);
 
-    int GetArity() const override;
+    int  GetArity() const override;
+    bool IsPure() const override { return m_pure; }
 
-    PopLObject Call(Interpreter&                   interpreter,
-                    const std::vector<PopLObject>& args) override;
+    PopLObject Call(Interpreter&                interpreter,
+                    std::span<const PopLObject> args) override;
 
     std::string ToString() const override;
 
@@ -31,6 +40,7 @@ class NativeFunction : public PoplCallable {
     std::string m_name;
     int         m_arity;
     FnType      m_function;
+    bool        m_pure;
 };
 
 }  // namespace callable
@@ -1,37 +1,61 @@
 #pragma once
 
-#include <memory>
 #include <optional>
 #include <string>
 
 #include "callable.hpp"
 #include "popl/environment.hpp"
 #include "popl/runtime/popl_instance.hpp"
+#include "popl/runtime/stats.hpp"
 #include "popl/syntax/ast/expr.hpp"
 
 namespace popl::callable {
 class PoplFunction : public PoplCallable {
    public:
-    PoplFunction(const FunctionExpr*          declaration,
-                 std::shared_ptr<Environment> closure,
-                 std::optional<std::string> name, bool isInitializer)
+    PoplFunction(const FunctionExpr*        declaration,
+                 runtime::Ref<Environment>  closure,
+                 std::optional<std::string> name, bool isInitializer,
+                 Upvalues                   upvalues = {})
         : m_declaration{declaration},
           m_name(std::move(name)),
           m_closure(std::move(closure)),
-          m_isInitializer(isInitializer) {}
+          m_upvalues(std::move(upvalues)),
+          m_isInitializer(isInitializer) {
+        POPL_STATS_OBJECT_CREATED(functions_created);
+    }
+    ~PoplFunction() override { POPL_STATS_OBJECT_DESTROYED(); }
 
-    PopLObject Call(Interpreter&                   interpreter,
-                    const std::vector<PopLObject>& args) override;
+    PopLObject Call(Interpreter&                interpreter,
+                    std::span<const PopLObject> args) override;
 
-    std::shared_ptr<PoplFunction> Bind(
-        std::shared_ptr<runtime::PoplInstance> instance);
+    runtime::Ref<PoplFunction> Bind(
+        runtime::Ref<runtime::PoplInstance> instance);
+    // Runs this initializer on `instance` like Bind(instance)->Call(), but
+    // without allocating the bound method or its environment
+    void Construct(Interpreter& interpreter, std::span<const PopLObject> args,
+                   runtime::Ref<runtime::PoplInstance> instance);
     int GetArity() const override { return m_declaration->params.size(); }
     std::string ToString() const override;
 
+    const FunctionExpr* GetDeclaration() const { return m_declaration; }
+    const std::optional<std::string>& GetName() const { return m_name; }
+    // Globals, or the environment holding `this` for a bound method
+    const runtime::Ref<Environment>& GetClosure() const { return m_closure; }
+    // Variables captured from enclosing functions and blocks
+    const Upvalues& GetUpvalues() const { return m_upvalues; }
+    bool IsInitializer() const { return m_isInitializer; }
+
+   private:
+    // Runs the body with `closure` enclosing the parameters
+    PopLObject Invoke(Interpreter&                interpreter,
+                      std::span<const PopLObject> args,
+                      runtime::Ref<Environment>   closure);
+
    private:
-    bool                         m_isInitializer;
-    const FunctionExpr*          m_declaration;
-    std::optional<std::string>   m_name;
-    std::shared_ptr<Environment> m_closure;
+    bool                       m_isInitializer;
+    const FunctionExpr*        m_declaration;
+    std::optional<std::string> m_name;
+    runtime::Ref<Environment>  m_closure;
+    Upvalues                   m_upvalues;
 };
 };  // namespace popl::callable
@@ -1,27 +1,36 @@
 #pragma once
 
+#include <cstdio>
 #include <string_view>
 
 #include "popl/lexer/token.hpp"
 #include "popl/runtime/run_time_error.hpp"
 
 namespace popl {
+/// Error sink of one interpreter. Each Interpreter owns its own instance so
+/// that independent interpreters can run on different threads.
 class Diagnostics {
    public:
-    static void Error(unsigned int line, std::string_view message);
-    static void Error(Token token, std::string_view message);
-    static void ReportRunTimeError(const runtime::RunTimeError& error);
+    // runtime errors go to `out`, compile errors to `err`
+    explicit Diagnostics(std::FILE* out = stdout, std::FILE* err = stderr)
+        : m_out{out}, m_err{err} {}
+
+    void Error(unsigned int line, std::string_view message);
+    void Error(Token token, std::string_view message);
+    void ReportRunTimeError(const runtime::RunTimeError& error);
     // mutually exclusive from run_time_error
-    static bool HadError() { return ms_had_error; }
-    static bool HadRunTimeError() { return ms_had_runtime_error; }
-    static void ResetError() { ms_had_error = false; }
+    bool HadError() const { return m_had_error; }
+    bool HadRunTimeError() const { return m_had_runtime_error; }
+    void ResetError() { m_had_error = false; }
 
    private:
-    static void Report(unsigned int line, std::string_view where,
-                       std::string_view message);
+    void Report(unsigned int line, std::string_view where,
+                std::string_view message);
 
    private:
-    static bool ms_had_error;
-    static bool ms_had_runtime_error;
+    std::FILE* m_out;
+    std::FILE* m_err;
+    bool       m_had_error{false};
+    bool       m_had_runtime_error{false};
 };
 }  // namespace popl
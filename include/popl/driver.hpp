@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <string_view>
 
+#include "popl/runtime/limits.hpp"
+#include "popl/runtime/tracer.hpp"
 #include "popl/syntax/visitors/interpreter.hpp"
 
 namespace popl {
@@ -10,17 +13,34 @@ namespace popl {
 class Driver {
    public:
     int Init(int argc, char** argv);
+    // Lexes, parses, resolves and interprets one program in-process. Globals
+    // persist across calls on the same Driver; each Driver is independent.
+    void Run(std::string source, bool replMode = false);
+    Interpreter& GetInterpreter() { return m_interpreter; }
+    Diagnostics& GetDiagnostics() { return m_interpreter.GetDiagnostics(); }
+    // Quotas enforced on every following Run(); exceeding one is reported as
+    // a runtime error
+    void SetLimits(const runtime::ResourceLimits& limits);
 
    private:
-    void Run(std::string source, bool replMode = false);
     void Run(const std::vector<Token>& tokens, bool replMode);
     int  RunRepl();
     int  RunFile(std::string_view path);
     void PrintUsage() const;
     bool IsStatementComplete(const std::vector<Token>& tokens) const;
+    // Returns false on an unknown option
+    bool ParseOption(std::string_view option);
+    // Writes the trace and prints statistics requested on the command line
+    void Finish() const;
+    void WriteTrace() const;
+    void PrintStats() const;
 
    private:
-    static Interpreter interpreter;
+    Interpreter                      m_interpreter{};
+    std::string                      m_trace_path{};
+    std::unique_ptr<runtime::Tracer> m_tracer{};
+    bool                             m_print_stats{false};
+    runtime::ResourceLimits          m_limits{};
 };
 
 }  // namespace popl
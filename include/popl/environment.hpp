@@ -1,18 +1,52 @@
 #pragma once
 
-#include <memory>
+#include <memory_resource>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "popl/lexer/token.hpp"
 #include "popl/literal.hpp"
+#include "popl/runtime/limits.hpp"
+#include "popl/runtime/object_pool.hpp"
+#include "popl/runtime/ref.hpp"
 #include "popl/runtime/run_time_error.hpp"
+#include "popl/runtime/stats.hpp"
 
 namespace popl {
-class Environment {
+/// Box for a variable that a closure captured. Shared by the environment that
+/// declared the variable and every closure that captured it, so assignments
+/// on either side are seen by the other.
+struct Cell : runtime::RefCounted, runtime::Pooled {
+    explicit Cell(PopLObject value) : value{std::move(value)} {}
+
+    PopLObject value;
+};
+
+// The cells a closure captured, in the order of its FunctionExpr's upvalues
+using Upvalues = std::pmr::vector<runtime::Ref<Cell>>;
+
+/// Created through Make() or on the stack with runtime::ScopedRef; variables
+/// live in the current pool. Closures never keep an environment alive:
+/// capturing a variable moves it into a Cell.
+class Environment : public runtime::RefCounted, public runtime::Pooled {
    public:
-    Environment(std::shared_ptr<Environment> enclosing)
-        : m_enclosing(std::move(enclosing)) {}
-    Environment() = default;
+    Environment(runtime::Ref<Environment> enclosing)
+        : m_enclosing(std::move(enclosing)) {
+        POPL_STATS_OBJECT_CREATED(environments_created);
+    }
+    Environment() { POPL_STATS_OBJECT_CREATED(environments_created); }
+    ~Environment() { POPL_STATS_OBJECT_DESTROYED(); }
+
+    // A heap environment, charged to the allocation budget. Stack
+    // environments are not: they are gone when their block or call ends.
+    template <typename... Args>
+    static runtime::Ref<Environment> Make(Args&&... args) {
+        runtime::ChargeAlloc(sizeof(Environment));
+        return runtime::MakeRef<Environment>(std::forward<Args>(args)...);
+    }
+
     const PopLObject& Get(const Token& name) const { return Lookup(name); }
     const PopLObject& GetAt(int depth, const Token& name) const {
         return LookupAt(depth, name);
@@ -24,11 +58,21 @@ class Environment {
     }
 
     void Define(const Token& name, PopLObject value) {
-        m_values.insert_or_assign(name.GetLexeme(), std::move(value));
+        Define(name.GetLexeme(), std::move(value));
     }
     void Define(const std::string& name, PopLObject value) {
+        // A closure may have captured the name before its declaration ran
+        if (Cell* cell = FindCell(name)) {
+            cell->value = std::move(value);
+            return;
+        }
         m_values.insert_or_assign(name, std::move(value));
     }
+    // Defines `name` as an already captured variable
+    void DefineCell(const std::string& name, runtime::Ref<Cell> cell) {
+        m_values.erase(name);
+        m_cells.emplace_back(name, std::move(cell));
+    }
     void Assign(const Token& name, PopLObject value) {
         PopLObject& obj = Lookup(name);
         obj             = std::move(value);
@@ -38,7 +82,55 @@ class Environment {
         obj             = std::move(value);
     }
 
+    // The cell holding `name`, `depth` environments up. The variable is moved
+    // into a new cell on its first capture, or declared uninitialized when it
+    // is not defined yet (a function referring to itself).
+    runtime::Ref<Cell> CaptureAt(int depth, const Token& name) {
+        Environment* cur = this;
+        while (depth > 0) {
+            cur = cur->m_enclosing.get();
+            assert(cur != nullptr && "Enclosing environment must exist");
+            --depth;
+        }
+        return cur->Capture(name.GetLexeme());
+    }
+
+    const runtime::Ref<Environment>& GetEnclosing() const {
+        return m_enclosing;
+    }
+    const std::pmr::unordered_map<std::string, PopLObject>& GetValues() const {
+        return m_values;
+    }
+    const auto& GetCells() const { return m_cells; }
+
    private:
+    Cell* FindCell(const std::string& name) {
+        for (auto& [cell_name, cell] : m_cells)
+            if (cell_name == name) return cell.get();
+        return nullptr;
+    }
+
+    runtime::Ref<Cell> Capture(const std::string& name) {
+        if (Cell* cell = FindCell(name)) return runtime::Ref<Cell>(cell);
+
+        PopLObject value{UninitializedValue{}};
+        auto       it = m_values.find(name);
+        if (it != m_values.end()) {
+            value = std::move(it->second);
+            m_values.erase(it);
+        }
+        auto captured = runtime::MakeRef<Cell>(std::move(value));
+        m_cells.emplace_back(name, captured);
+        return captured;
+    }
+
+    PopLObject* Find(const std::string& name) {
+        auto it = m_values.find(name);
+        if (it != m_values.end()) return &it->second;
+        Cell* cell = FindCell(name);
+        return cell ? &cell->value : nullptr;
+    }
+
     PopLObject& LookupAt(int depth, const Token& name) {
         Environment* cur = this;
         while (depth > 0) {
@@ -46,8 +138,7 @@ class Environment {
             assert(cur != nullptr && "Enclosing environment must exist");
             --depth;
         }
-        auto it = cur->m_values.find(name.GetLexeme());
-        if (it != cur->m_values.end()) return it->second;
+        if (PopLObject* value = cur->Find(name.GetLexeme())) return *value;
 
         throw runtime::RunTimeError(
             name, "Undefined variable '" + name.GetLexeme() + "'.");
@@ -57,8 +148,7 @@ class Environment {
     }
 
     PopLObject& Lookup(const Token& name) {
-        auto it = m_values.find(name.GetLexeme());
-        if (it != m_values.end()) return it->second;
+        if (PopLObject* value = Find(name.GetLexeme())) return *value;
 
         if (m_enclosing) return m_enclosing->Lookup(name);
 
@@ -71,9 +161,13 @@ class Environment {
     }
 
    private:
-    /// for a child to exist its parent must exist, therefore shared_ptr and not
-    /// weak_ptr
-    std::shared_ptr<Environment>                m_enclosing;
-    std::unordered_map<std::string, PopLObject> m_values;
+    /// for a child to exist its parent must exist, therefore a strong
+    /// reference
+    runtime::Ref<Environment>                        m_enclosing;
+    std::pmr::unordered_map<std::string, PopLObject> m_values{
+        runtime::CurrentResource()};
+    // Captured variables, moved out of m_values; rarely more than a few
+    std::pmr::vector<std::pair<std::string, runtime::Ref<Cell>>> m_cells{
+        runtime::CurrentResource()};
 };
 }  // namespace popl
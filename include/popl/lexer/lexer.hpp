@@ -10,9 +10,12 @@
 
 namespace popl {
 
+class Diagnostics;
+
 class Lexer {
    public:
-    Lexer(std::string source) : m_source(std::move(source)) {}
+    Lexer(std::string source, Diagnostics& diagnostics)
+        : m_source(std::move(source)), m_diagnostics(diagnostics) {}
     std::vector<Token> ScanTokens();
 
     std::vector<Token> GetTokens() const { return m_tokens; }
@@ -49,6 +52,7 @@ class Lexer {
 
    private:
     std::string        m_source;
+    Diagnostics&       m_diagnostics;
     std::vector<Token> m_tokens{};
 
     size_t m_start{};    // first character in lexeme being scanned
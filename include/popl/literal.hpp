@@ -6,7 +6,12 @@
 #include <variant>
 
 #include "popl/callables/callable.hpp"
+#include "popl/runtime/float64_array.hpp"
+#include "popl/runtime/popl_array.hpp"
 #include "popl/runtime/popl_instance.hpp"
+#include "popl/runtime/popl_map.hpp"
+#include "popl/runtime/popl_string.hpp"
+#include "popl/runtime/ref.hpp"
 
 namespace popl {
 struct UninitializedValue {};
@@ -19,19 +24,31 @@ inline bool operator==(const NilValue&, const NilValue&) { return false; }
 
 class PopLObject {
    public:
-    using CallablePtr = std::shared_ptr<callable::PoplCallable>;
-    using InstancePtr = std::shared_ptr<runtime::PoplInstance>;
-    using Value       = std::variant<UninitializedValue, NilValue, double,
-                                     std::string, bool, CallablePtr, InstancePtr>;
+    using StringPtr       = runtime::PoplString::Ptr;
+    using CallablePtr     = runtime::Ref<callable::PoplCallable>;
+    using InstancePtr     = runtime::Ref<runtime::PoplInstance>;
+    using ArrayPtr        = std::shared_ptr<runtime::PoplArray>;
+    using MapPtr          = std::shared_ptr<runtime::PoplMap>;
+    using Float64ArrayPtr = std::shared_ptr<runtime::Float64Array>;
+    using Value           =
+        std::variant<UninitializedValue, NilValue, double, StringPtr, bool,
+                     CallablePtr, InstancePtr, ArrayPtr, MapPtr,
+                     Float64ArrayPtr>;
 
     explicit PopLObject(UninitializedValue v) : m_data(v) {}
     explicit PopLObject(NilValue n) : m_data{n} {}
     explicit PopLObject(double d) : m_data(d) {}
     explicit PopLObject(bool b) : m_data(b) {}
-    explicit PopLObject(const std::string& str) : m_data(str) {}
-    explicit PopLObject(std::string&& str) : m_data(std::move(str)) {}
-    explicit PopLObject(CallablePtr ptr) : m_data(ptr) {}
-    explicit PopLObject(InstancePtr ptr) : m_data(ptr) {}
+    explicit PopLObject(const std::string& str)
+        : m_data(std::make_shared<const runtime::PoplString>(str)) {}
+    explicit PopLObject(std::string&& str)
+        : m_data(std::make_shared<const runtime::PoplString>(std::move(str))) {}
+    explicit PopLObject(StringPtr ptr) : m_data(std::move(ptr)) {}
+    explicit PopLObject(CallablePtr ptr) : m_data(std::move(ptr)) {}
+    explicit PopLObject(InstancePtr ptr) : m_data(std::move(ptr)) {}
+    explicit PopLObject(ArrayPtr ptr) : m_data(std::move(ptr)) {}
+    explicit PopLObject(MapPtr ptr) : m_data(std::move(ptr)) {}
+    explicit PopLObject(Float64ArrayPtr ptr) : m_data(std::move(ptr)) {}
 
     // type checks
     bool isNil() const { return std::holds_alternative<NilValue>(m_data); }
@@ -40,7 +57,7 @@ class PopLObject {
     }
     bool isNumber() const { return std::holds_alternative<double>(m_data); }
     bool isString() const {
-        return std::holds_alternative<std::string>(m_data);
+        return std::holds_alternative<StringPtr>(m_data);
     }
     bool isBool() const { return std::holds_alternative<bool>(m_data); }
     bool isCallable() const {
@@ -49,15 +66,32 @@ class PopLObject {
     bool isInstance() const {
         return std::holds_alternative<InstancePtr>(m_data);
     }
+    bool isArray() const { return std::holds_alternative<ArrayPtr>(m_data); }
+    bool isMap() const { return std::holds_alternative<MapPtr>(m_data); }
+    bool isFloat64Array() const {
+        return std::holds_alternative<Float64ArrayPtr>(m_data);
+    }
 
     // accessors throws on misuse
     double             asNumber() const { return std::get<double>(m_data); }
     const std::string& asString() const {
-        return std::get<std::string>(m_data);
+        return std::get<StringPtr>(m_data)->Get();
+    }
+    // Without flattening a rope
+    const StringPtr& asStringPtr() const { return std::get<StringPtr>(m_data); }
+    // References into the value; copy them to keep the object alive
+    const CallablePtr& asCallable() const {
+        return std::get<CallablePtr>(m_data);
+    }
+    const InstancePtr& asInstance() const {
+        return std::get<InstancePtr>(m_data);
+    }
+    const ArrayPtr& asArray() const { return std::get<ArrayPtr>(m_data); }
+    const MapPtr&   asMap() const { return std::get<MapPtr>(m_data); }
+    const Float64ArrayPtr& asFloat64Array() const {
+        return std::get<Float64ArrayPtr>(m_data);
     }
-    CallablePtr asCallable() const { return std::get<CallablePtr>(m_data); }
-    InstancePtr asInstance() const { return std::get<InstancePtr>(m_data); }
-    bool        asBool() const { return std::get<bool>(m_data); }
+    bool asBool() const { return std::get<bool>(m_data); }
 
     bool isTruthy() const {
         if (isNil() || isUninitialized()) return false;
@@ -84,8 +118,14 @@ class PopLObject {
                     return s;
                 } else if constexpr (std::is_same_v<T, InstancePtr>) {
                     return v ? v->ToString() : "<null instance>";
+                } else if constexpr (std::is_same_v<T, ArrayPtr>) {
+                    return v ? v->ToString() : "<null array>";
+                } else if constexpr (std::is_same_v<T, MapPtr>) {
+                    return v ? v->ToString() : "<null map>";
+                } else if constexpr (std::is_same_v<T, Float64ArrayPtr>) {
+                    return v ? v->ToString() : "<null float64 array>";
                 } else
-                    return v;
+                    return v->Get();
             },
             m_data);
     }
@@ -98,7 +138,11 @@ class PopLObject {
                 using X = std::decay_t<decltype(x)>;
                 using Y = std::decay_t<decltype(y)>;
 
-                if constexpr (std::is_same_v<X, Y>)
+                if constexpr (std::is_same_v<X, StringPtr> &&
+                              std::is_same_v<Y, StringPtr>)
+                    return x == y || (x->Size() == y->Size() &&
+                                      x->Get() == y->Get());
+                else if constexpr (std::is_same_v<X, Y>)
                     return x == y;
                 else
                     return false;
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <unordered_map>
+
+namespace popl::runtime {
+
+class EventLoop;
+
+/// Fire-and-forget coroutine behind an async native. The coroutine's first
+/// parameter must be the EventLoop it waits on. It runs eagerly up to its
+/// first co_await and frees itself when it finishes. An exception that
+/// escapes it is rethrown from EventLoop::Run().
+class AsyncTask {
+   public:
+    struct promise_type {
+        template <typename... Args>
+        explicit promise_type(EventLoop& loop_, Args&&...) : loop{loop_} {}
+
+        AsyncTask          get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void               return_void() {}
+        void               unhandled_exception();
+
+        EventLoop& loop;
+    };
+};
+
+/// Single-threaded epoll loop owned by one interpreter. Async natives suspend
+/// on it until a file descriptor becomes readable or a timer fires; the
+/// interpreter runs the loop once the script's statements are done.
+class EventLoop {
+   public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&)            = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Resumes suspended tasks until none are left. Returns false, leaving the
+    // rest suspended, if it would have to wait for them past `deadline`
+    bool Run(std::optional<std::chrono::steady_clock::time_point> deadline =
+                 std::nullopt);
+    // Drops every suspended task
+    void Clear();
+    void Fail(std::exception_ptr error);
+
+    class Awaiter {
+       public:
+        Awaiter(EventLoop& loop, int fd) : m_loop{loop}, m_fd{fd} {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+
+       private:
+        EventLoop& m_loop;
+        int        m_fd;  // owned by the awaiter, -1 to just yield
+    };
+
+    // Resumes after `delay`
+    Awaiter Sleep(std::chrono::milliseconds delay);
+    // Resumes once `fd` has data or hit EOF; regular files are always ready
+    Awaiter Readable(int fd);
+    // Lets other ready tasks run first
+    Awaiter Yield() { return Awaiter{*this, -1}; }
+
+   private:
+    void Watch(int fd, std::coroutine_handle<> handle);
+    // Queues the tasks whose descriptors are ready, waiting up to
+    // `timeout_ms` for the first (-1 waits for good)
+    void Poll(int timeout_ms);
+
+   private:
+    int                                              m_epoll;
+    std::unordered_map<int, std::coroutine_handle<>> m_waiting{};
+    std::deque<std::coroutine_handle<>>              m_ready{};
+    std::exception_ptr                               m_error{};
+};
+
+}  // namespace popl::runtime
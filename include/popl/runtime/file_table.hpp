@@ -0,0 +1,81 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "popl/runtime/output_buffer.hpp"
+
+namespace popl::runtime {
+
+/// File opened by a script. Reads go through a 64 KiB buffer that lines and
+/// chunks are cut from directly; writes go through an OutputBuffer.
+class File {
+   public:
+    enum class Mode { READ, WRITE, APPEND };
+
+    static constexpr std::size_t kBufferSize = 64 * 1024;
+
+    // Most ReadChunk() reads at once, however much was asked for
+    static constexpr std::size_t kMaxDirectRead = 16 * kBufferSize;
+
+    // nullptr with errno set when open(2) fails
+    static std::unique_ptr<File> Open(const std::string& path, Mode mode);
+    ~File();
+    File(const File&)            = delete;
+    File& operator=(const File&) = delete;
+
+    bool IsReadable() const { return m_mode == Mode::READ; }
+
+    // The next line without its '\n'; nullopt at end of file
+    std::optional<std::string> ReadLine();
+    // Up to `max` bytes, fewer when less is available as with read(2);
+    // empty at end of file, nullopt with errno set when reading fails
+    std::optional<std::string> ReadChunk(std::size_t max);
+    void        Write(std::string_view text);
+    void        Flush();
+
+   private:
+    File(int fd, Mode mode);
+    // Refills the empty read buffer and returns what read(2) did: the bytes
+    // read, 0 at end of file or -1 with errno set
+    ssize_t Fill();
+
+   private:
+    int                           m_fd;
+    Mode                          m_mode;
+    std::unique_ptr<char[]>       m_buffer{};
+    std::size_t                   m_begin{0};
+    std::size_t                   m_end{0};
+    std::unique_ptr<OutputBuffer> m_output{};
+};
+
+/// Files opened by one interpreter, addressed by the numeric ids scripts see.
+/// Whatever is still open is flushed and closed with the table.
+class FileTable {
+   public:
+    using Id = std::uint32_t;
+
+    Id Add(std::unique_ptr<File> file);
+    // nullptr if `id` is unknown or closed
+    File* Get(Id id) const;
+    // False if `id` is unknown or already closed
+    bool Close(Id id);
+    void FlushAll();
+
+   private:
+    std::unordered_map<Id, std::unique_ptr<File>> m_files{};
+    Id                                            m_next_id{1};
+};
+
+// Whole contents of `path`, read through mmap(2) when it is a regular file;
+// nullopt with errno set on failure
+std::optional<std::string> ReadWholeFile(const std::string& path);
+
+}  // namespace popl::runtime
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "popl/runtime/limits.hpp"
+
+namespace popl::runtime {
+
+/// Fixed-length array of raw doubles for numeric work; the vector kernels
+/// run straight over its storage. Shared by reference like other arrays.
+class Float64Array {
+   public:
+    // Zero-filled
+    explicit Float64Array(std::size_t size) : m_data(Zeroed(size)) {}
+    explicit Float64Array(std::vector<double> data)
+        : m_data(std::move(data)) {
+        ChargeAlloc(Bytes(m_data.size()));
+    }
+
+    // What an array of `size` elements charges to the allocation budget
+    static std::size_t Bytes(std::size_t size) {
+        return sizeof(Float64Array) + size * sizeof(double);
+    }
+
+    std::size_t   Size() const { return m_data.size(); }
+    double*       Data() { return m_data.data(); }
+    const double* Data() const { return m_data.data(); }
+
+    std::string ToString() const;
+
+   private:
+    // Charged before the storage is allocated
+    static std::vector<double> Zeroed(std::size_t size) {
+        ChargeAlloc(Bytes(size));
+        return std::vector<double>(size);
+    }
+
+   private:
+    std::vector<double> m_data;
+};
+};  // namespace popl::runtime
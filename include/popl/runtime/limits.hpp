@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+
+namespace popl::runtime {
+
+/// Per-run quotas and permissions for untrusted scripts. Zero means
+/// unlimited; permissions are off unless the host grants them.
+struct ResourceLimits {
+    std::uint64_t             max_statements{0};
+    std::chrono::milliseconds max_wall_time{0};
+    // Allocation budget: total bytes of strings, heap environments,
+    // instances, arrays and maps allocated by a run, whether or not they are
+    // still live. Freed memory is not credited back, so a long run with a
+    // small working set can still exhaust it.
+    std::uint64_t             max_alloc_bytes{0};
+    std::uint32_t             max_call_depth{0};
+    // execAsync() hands its argument to /bin/sh -c, so a script allowed to
+    // call it can run any command as the host user: a shell injection
+    // surface for any script built from untrusted input
+    bool                      allow_exec{false};
+    // openFile(), readFile() and readFileAsync() reach any path the host
+    // user can, for reading and writing
+    bool                      allow_files{false};
+};
+
+/// Accounting against ResourceLimits for one top-level run, an
+/// Interpreter::Interpret() call. Workers and parallel tasks that the run
+/// starts share its budget through Inherit(), so splitting work across
+/// threads does not multiply it. Statements are only counted on the hot
+/// path, into the meter's own counters; those are added to the shared budget
+/// and the limits (and the clock) checked every kCheckInterval statements,
+/// or on the next statement once an allocation went over budget. Each
+/// thread may therefore overrun a limit by up to kCheckInterval statements.
+class ResourceMeter {
+   public:
+    enum class Exceeded { NONE, STATEMENTS, WALL_TIME, ALLOCATION };
+
+    static constexpr std::uint64_t kCheckInterval = 1024;
+
+    void SetLimits(const ResourceLimits& limits) { m_limits = limits; }
+    const ResourceLimits& GetLimits() const { return m_limits; }
+
+    void Start() {
+        m_budget      = std::make_shared<Budget>();
+        m_statements  = m_flushed_statements  = 0;
+        m_alloc_bytes = m_flushed_alloc_bytes = 0;
+        m_start       = std::chrono::steady_clock::now();
+        ScheduleNextCheck();
+    }
+    // Charges `parent`'s budget from now on, under its limits and deadline,
+    // so work handed to another interpreter is taken out of the same budget
+    void Inherit(const ResourceMeter& parent) {
+        m_limits = parent.m_limits;
+        m_budget = parent.m_budget ? parent.m_budget
+                                   : std::make_shared<Budget>();
+        m_start  = parent.m_start;
+        m_statements = m_flushed_statements =
+            m_budget->statements.load(std::memory_order_relaxed);
+        m_alloc_bytes = m_flushed_alloc_bytes =
+            m_budget->alloc_bytes.load(std::memory_order_relaxed);
+        ScheduleNextCheck();
+    }
+    // Adds what this meter counted since the last call to the shared budget
+    // and catches up with what the other meters sharing it added
+    void Flush() {
+        if (!m_budget) return;
+        Merge(m_budget->statements, m_statements, m_flushed_statements);
+        Merge(m_budget->alloc_bytes, m_alloc_bytes, m_flushed_alloc_bytes);
+    }
+
+    // Returns true when Check() needs to run
+    bool CountStatement() { return ++m_statements >= m_next_check; }
+
+    void ChargeAlloc(std::size_t bytes) {
+        m_alloc_bytes += bytes;
+        if (m_limits.max_alloc_bytes &&
+            m_alloc_bytes > m_limits.max_alloc_bytes)
+            m_next_check = 0;
+    }
+
+    // Whether `bytes` more stay within the allocation limit
+    bool Fits(std::size_t bytes) const {
+        return !m_limits.max_alloc_bytes ||
+               (m_alloc_bytes <= m_limits.max_alloc_bytes &&
+                bytes <= m_limits.max_alloc_bytes - m_alloc_bytes);
+    }
+
+    Exceeded Check() {
+        Flush();
+        if (m_limits.max_alloc_bytes &&
+            m_alloc_bytes > m_limits.max_alloc_bytes)
+            return Exceeded::ALLOCATION;
+        if (m_limits.max_statements &&
+            m_statements > m_limits.max_statements)
+            return Exceeded::STATEMENTS;
+        if (m_limits.max_wall_time.count() &&
+            std::chrono::steady_clock::now() - m_start >
+                m_limits.max_wall_time)
+            return Exceeded::WALL_TIME;
+        ScheduleNextCheck();
+        return Exceeded::NONE;
+    }
+
+    // When the wall-time limit runs out, if there is one
+    std::optional<std::chrono::steady_clock::time_point> GetDeadline() const {
+        if (!m_limits.max_wall_time.count()) return std::nullopt;
+        return m_start + m_limits.max_wall_time;
+    }
+
+    std::uint64_t GetStatements() const { return m_statements; }
+    std::uint64_t GetAllocBytes() const { return m_alloc_bytes; }
+
+   private:
+    // Totals of every meter charging one run
+    struct Budget {
+        std::atomic<std::uint64_t> statements{0};
+        std::atomic<std::uint64_t> alloc_bytes{0};
+    };
+
+    static void Merge(std::atomic<std::uint64_t>& total, std::uint64_t& seen,
+                      std::uint64_t& flushed) {
+        std::uint64_t pending = seen - flushed;
+        seen = flushed = total.fetch_add(pending, std::memory_order_relaxed) +
+                         pending;
+    }
+    void ScheduleNextCheck() {
+        bool timed = m_limits.max_wall_time.count() != 0;
+        if (!timed && !m_limits.max_statements && !m_limits.max_alloc_bytes) {
+            m_next_check = std::numeric_limits<std::uint64_t>::max();
+            return;
+        }
+        m_next_check = m_statements + kCheckInterval;
+        if (m_limits.max_statements)
+            m_next_check = std::min(m_next_check, m_limits.max_statements + 1);
+    }
+
+   private:
+    ResourceLimits                        m_limits{};
+    std::shared_ptr<Budget>               m_budget{};
+    // The run's totals as this meter sees them: the shared budget as of the
+    // last Flush() plus what this meter counted since
+    std::uint64_t                         m_statements{0};
+    std::uint64_t                         m_alloc_bytes{0};
+    std::uint64_t                         m_flushed_statements{0};
+    std::uint64_t                         m_flushed_alloc_bytes{0};
+    std::uint64_t                         m_next_check{
+        std::numeric_limits<std::uint64_t>::max()};
+    std::chrono::steady_clock::time_point m_start{};
+};
+
+/// Meter of the interpreter currently running on this thread; runtime objects
+/// that are allocated away from the interpreter (environments, instances)
+/// charge their size to it.
+inline thread_local ResourceMeter* t_current_meter = nullptr;
+
+inline void ChargeAlloc(std::size_t bytes) {
+    if (t_current_meter) t_current_meter->ChargeAlloc(bytes);
+}
+
+}  // namespace popl::runtime
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "popl/runtime/ref.hpp"
+
+namespace popl::runtime {
+
+/// Memory for one interpreter's environments, functions and instances and for
+/// their hash-map nodes. POOLED recycles blocks through per-size free lists
+/// instead of going to malloc for every call, block and closure; SYSTEM uses
+/// the global heap and exists for comparison. The pool is not thread-safe:
+/// objects allocated from it must be created and freed by whichever thread
+/// is running its interpreter. Every pooled object keeps the pool alive.
+class ObjectPool : public RefCounted {
+   public:
+    enum class Strategy { POOLED, SYSTEM };
+
+    explicit ObjectPool(Strategy strategy = Strategy::POOLED)
+        : m_strategy{strategy} {}
+
+    Strategy                   GetStrategy() const { return m_strategy; }
+    std::pmr::memory_resource* Resource() {
+        if (m_strategy == Strategy::SYSTEM)
+            return std::pmr::new_delete_resource();
+        return &m_pool;
+    }
+
+   private:
+    Strategy                              m_strategy;
+    std::pmr::unsynchronized_pool_resource m_pool{};
+};
+
+/// Base of the objects that `new` places in the current pool (see below).
+/// Each block is prefixed with the pool it came from, so it can be freed
+/// after the pool stopped being current.
+class Pooled {
+   public:
+    static void* operator new(std::size_t size);
+    static void  operator delete(void* ptr, std::size_t size);
+
+   protected:
+    ~Pooled() = default;
+};
+
+/// Pool of the interpreter currently running on this thread, set alongside
+/// t_current_meter. Null outside a run and while values are detached for
+/// another thread, in which case objects come from the global heap.
+inline thread_local ObjectPool* t_current_pool = nullptr;
+
+class CurrentPoolScope {
+   public:
+    explicit CurrentPoolScope(ObjectPool* pool) : m_previous{t_current_pool} {
+        t_current_pool = pool;
+    }
+    ~CurrentPoolScope() { t_current_pool = m_previous; }
+    CurrentPoolScope(const CurrentPoolScope&)            = delete;
+    CurrentPoolScope& operator=(const CurrentPoolScope&) = delete;
+
+   private:
+    ObjectPool* m_previous;
+};
+
+// For containers inside pooled objects; must be called while constructing
+// the object so both come from the same pool
+inline std::pmr::memory_resource* CurrentResource() {
+    return t_current_pool ? t_current_pool->Resource()
+                          : std::pmr::new_delete_resource();
+}
+
+}  // namespace popl::runtime
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace popl::runtime {
+
+/// Buffer for a script's standard output (print() and the REPL echo). Bytes
+/// are handed to write(2) only when the buffer fills, at a newline in LINE
+/// mode, or on Flush(). Each interpreter owns one; the interpreter flushes it
+/// after every run and before reporting a runtime error.
+class OutputBuffer {
+   public:
+    // AUTO is LINE when the descriptor is a terminal and FULL otherwise
+    enum class Mode { AUTO, LINE, FULL };
+
+    static constexpr std::size_t kCapacity = 64 * 1024;
+
+    explicit OutputBuffer(int fd = 1, Mode mode = Mode::AUTO);
+    ~OutputBuffer();
+    OutputBuffer(const OutputBuffer&)            = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void SetMode(Mode mode);
+    // Never AUTO
+    Mode GetMode() const { return m_mode; }
+
+    void Write(std::string_view text);
+    void WriteLine(std::string_view text);
+    // Also flushes stdio's stdout first, so earlier std::print output to the
+    // same descriptor stays in order. Write errors drop the pending bytes.
+    void Flush();
+
+   private:
+    void Append(std::string_view text);
+
+   private:
+    int                     m_fd;
+    Mode                    m_mode{Mode::FULL};
+    std::unique_ptr<char[]> m_data;
+    std::size_t             m_size{0};
+};
+
+}  // namespace popl::runtime
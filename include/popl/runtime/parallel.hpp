@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+
+#include "popl/literal.hpp"
+#include "popl/runtime/popl_array.hpp"
+
+namespace popl {
+class Interpreter;
+}
+
+namespace popl::runtime {
+
+// Data-parallel natives on the shared WorkStealingPool. `fn` runs on
+// per-thread interpreters that start from a snapshot of the caller's globals
+// and of `fn`'s closure, so writes made by `fn` are not seen by the caller.
+
+// [fn(items[0]), fn(items[1]), ...], in the original order
+std::shared_ptr<PoplArray> ParallelMap(Interpreter&                      caller,
+                                       const std::shared_ptr<PoplArray>& items,
+                                       const PopLObject&                 fn);
+// fn(...fn(fn(init, items[0]), items[1])..., items[n-1]) for an associative
+// `fn`: chunks are reduced in parallel and then folded in order
+PopLObject ParallelReduce(Interpreter&                      caller,
+                          const std::shared_ptr<PoplArray>& items,
+                          const PopLObject& fn, const PopLObject& init);
+
+}  // namespace popl::runtime
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "popl/runtime/limits.hpp"
+
+namespace popl {
+class PopLObject;
+};  // namespace popl
+
+namespace popl::runtime {
+
+/// Growable array of PopL values, shared by reference like instances.
+class PoplArray {
+   public:
+    PoplArray();
+    explicit PoplArray(std::vector<popl::PopLObject> elements);
+    ~PoplArray();
+
+    std::size_t                          Size() const;
+    // Amortized O(1); storage grows geometrically and is charged on growth
+    void                                 Push(popl::PopLObject value);
+    std::vector<popl::PopLObject>&       GetElements() { return m_elements; }
+    const std::vector<popl::PopLObject>& GetElements() const {
+        return m_elements;
+    }
+
+    std::string ToString() const;
+
+   private:
+    std::vector<popl::PopLObject> m_elements;
+};
+};  // namespace popl::runtime
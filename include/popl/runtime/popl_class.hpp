@@ -1,6 +1,5 @@
 #pragma once
 
-#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -9,26 +8,31 @@
 
 namespace popl {
 namespace runtime {
-class PoplClass : public popl::callable::PoplCallable,
-                  public std::enable_shared_from_this<PoplClass> {
+class PoplClass : public popl::callable::PoplCallable {
    public:
-    PoplClass(
-        std::string name,
-        std::unordered_map<std::string, std::shared_ptr<callable::PoplFunction>>
-            methods)
-        : m_name(std::move(name)), m_methods(std::move(methods)) {}
+    PoplClass(std::string name,
+              std::unordered_map<std::string, Ref<callable::PoplFunction>>
+                  methods);
 
-    popl::PopLObject Call(popl::Interpreter&                   interpreter,
-                          const std::vector<popl::PopLObject>& args) override;
-    std::optional<std::shared_ptr<callable::PoplFunction>> GetMethod(
+    popl::PopLObject Call(popl::Interpreter&                interpreter,
+                          std::span<const popl::PopLObject> args) override;
+    std::optional<Ref<callable::PoplFunction>> GetMethod(
         const std::string& name) const;
     std::string ToString() const override { return m_name; }
-    int         GetArity() const override;
+    int         GetArity() const override { return m_arity; }
+
+    const std::string& GetName() const { return m_name; }
+    const std::unordered_map<std::string, Ref<callable::PoplFunction>>&
+    GetMethods() const {
+        return m_methods;
+    }
 
    private:
     std::string m_name;
-    std::unordered_map<std::string, std::shared_ptr<callable::PoplFunction>>
-        m_methods;
+    std::unordered_map<std::string, Ref<callable::PoplFunction>> m_methods;
+    // Looked up once, as every construction needs them
+    Ref<callable::PoplFunction> m_initializer;
+    int                         m_arity{0};
 };
 }  // namespace runtime
 }  // namespace popl
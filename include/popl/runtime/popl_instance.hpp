@@ -1,9 +1,14 @@
 #pragma once
 
-#include <memory>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 
+#include "popl/runtime/limits.hpp"
+#include "popl/runtime/object_pool.hpp"
+#include "popl/runtime/ref.hpp"
+#include "popl/runtime/stats.hpp"
+
 namespace popl {
 class Token;
 class PopLObject;
@@ -13,18 +18,28 @@ namespace popl::runtime {
 
 class PoplClass;
 
-class PoplInstance : public std::enable_shared_from_this<PoplInstance> {
+/// Created through MakeRef(); fields live in the same pool.
+class PoplInstance : public RefCounted, public Pooled {
    public:
-    explicit PoplInstance(std::shared_ptr<PoplClass> klass)
-        : m_creator_class(klass) {}
+    explicit PoplInstance(Ref<PoplClass> klass);
+    ~PoplInstance();
 
     popl::PopLObject Get(const popl::Token& name);
-    void             Set(Token name, popl::PopLObject value);
+    void             Set(const Token& name, popl::PopLObject value);
+    void             Set(std::string name, popl::PopLObject value);
 
     std::string ToString() const;
 
+    const Ref<PoplClass>& GetClass() const {
+        return m_creator_class;
+    }
+    const std::pmr::unordered_map<std::string, popl::PopLObject>& GetFields()
+        const {
+        return m_fields;
+    }
+
    private:
-    std::shared_ptr<PoplClass>                        m_creator_class;
-    std::unordered_map<std::string, popl::PopLObject> m_fields;
+    Ref<PoplClass>                                         m_creator_class;
+    std::pmr::unordered_map<std::string, popl::PopLObject> m_fields;
 };
 };  // namespace popl::runtime
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "popl/runtime/limits.hpp"
+
+namespace popl {
+class PopLObject;
+};  // namespace popl
+
+namespace popl::runtime {
+
+/// Hash map keyed by numbers, strings and booleans, shared by reference like
+/// arrays. Open addressing over one flat slot array: a control byte per slot
+/// holds 7 bits of the key's hash, and lookups compare a group of 16 control
+/// bytes at once before touching any slot. Slots cache the full hash, so
+/// growing never rehashes a key. Iteration order is unspecified.
+class PoplMap {
+   public:
+    using Visitor =
+        std::function<void(const popl::PopLObject&, const popl::PopLObject&)>;
+
+    PoplMap();
+    ~PoplMap();
+
+    // Numbers (except NaN), strings and booleans
+    static bool IsHashable(const popl::PopLObject& key);
+
+    std::size_t Size() const { return m_size; }
+
+    // `key` must be hashable; nullptr when absent
+    const popl::PopLObject* Find(const popl::PopLObject& key) const;
+    void                    Set(popl::PopLObject key, popl::PopLObject value);
+    bool                    Erase(const popl::PopLObject& key);
+    void                    ForEach(const Visitor& visit) const;
+
+    std::string ToString() const;
+
+   private:
+    struct Slot;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t Capacity() const { return m_ctrl.size(); }
+    std::size_t FindSlot(const popl::PopLObject& key, std::size_t hash) const;
+    std::size_t FindFree(std::size_t hash) const;
+    void        Rehash(std::size_t capacity);
+
+   private:
+    std::vector<std::int8_t> m_ctrl{};
+    std::vector<Slot>        m_slots;
+    std::size_t              m_size{0};
+    std::size_t              m_deleted{0};
+};
+};  // namespace popl::runtime
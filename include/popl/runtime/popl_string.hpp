@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "popl/runtime/limits.hpp"
+
+namespace popl::runtime {
+
+/// Immutable string value, shared by reference so copying a PopL string is
+/// O(1). Concatenating long strings builds a rope node instead of copying
+/// both sides; the node is flattened into one buffer the first time its
+/// contents are read, so a `s = s + piece` loop copies each byte about once.
+class PoplString {
+   public:
+    using Ptr = std::shared_ptr<const PoplString>;
+
+    // Results shorter than this are copied eagerly rather than roped
+    static constexpr std::size_t kMinRopeSize = 256;
+
+    explicit PoplString(std::string text)
+        : m_text(std::move(text)), m_size{m_text.size()} {}
+    ~PoplString();
+    PoplString(const PoplString&)            = delete;
+    PoplString& operator=(const PoplString&) = delete;
+
+    static Ptr Concat(const Ptr& left, const Ptr& right);
+
+    std::size_t Size() const { return m_size; }
+    // Flattens a rope node in place; not safe to race with another reader
+    // of the same node, so transfers between interpreters flatten first
+    const std::string& Get() const {
+        if (m_left) Flatten();
+        return m_text;
+    }
+
+   private:
+    PoplString(Ptr left, Ptr right);
+    void Flatten() const;
+
+   private:
+    // Empty while this is a rope node
+    mutable std::string m_text;
+    mutable Ptr         m_left{};
+    mutable Ptr         m_right{};
+    std::size_t         m_size;
+};
+};  // namespace popl::runtime
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <unordered_set>
+
+namespace popl::runtime {
+
+/// Marks a container as being printed while in scope, so that ToString() of
+/// an array or map that contains itself prints the inner occurrence as
+/// "[...]" or "{...}" instead of recursing until the stack overflows. Values
+/// are printed on the thread of the interpreter that owns them, so the set of
+/// containers being printed is per thread.
+class PrintGuard {
+   public:
+    explicit PrintGuard(const void* container)
+        : m_container{container},
+          m_entered{Printing().insert(container).second} {}
+    ~PrintGuard() {
+        if (m_entered) Printing().erase(m_container);
+    }
+    PrintGuard(const PrintGuard&)            = delete;
+    PrintGuard& operator=(const PrintGuard&) = delete;
+
+    // False when the container is already being printed further out
+    bool Entered() const { return m_entered; }
+
+   private:
+    static std::unordered_set<const void*>& Printing() {
+        thread_local std::unordered_set<const void*> printing;
+        return printing;
+    }
+
+   private:
+    const void* m_container;
+    bool        m_entered;
+};
+
+}  // namespace popl::runtime
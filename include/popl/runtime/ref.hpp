@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace popl::runtime {
+
+/// Base of objects owned through Ref<T>. The count is a plain integer: an
+/// object must only be referenced from the thread of the interpreter that
+/// owns it, which the transfer functions guarantee by copying instead of
+/// sharing. Copies of an object start unreferenced.
+class RefCounted {
+   public:
+    RefCounted() = default;
+    RefCounted(const RefCounted&) {}
+    RefCounted& operator=(const RefCounted&) { return *this; }
+
+    void AddRef() const { ++m_refs; }
+    // True when the last reference was dropped
+    bool          Release() const { return --m_refs == 0; }
+    std::uint32_t RefCount() const { return m_refs; }
+
+   protected:
+    ~RefCounted() = default;
+
+   private:
+    mutable std::uint32_t m_refs{0};
+};
+
+/// Intrusive counterpart of std::shared_ptr for RefCounted objects: one
+/// pointer wide, no control block, no atomic operations. Deletes through T,
+/// so T must be the dynamic type or have a virtual destructor.
+template <typename T>
+class Ref {
+   public:
+    Ref() = default;
+    Ref(std::nullptr_t) {}
+    // Adopts `ptr`, which may already be referenced elsewhere
+    explicit Ref(T* ptr) : m_ptr{ptr} {
+        if (m_ptr) m_ptr->AddRef();
+    }
+    Ref(const Ref& other) : Ref(other.m_ptr) {}
+    Ref(Ref&& other) noexcept : m_ptr{std::exchange(other.m_ptr, nullptr)} {}
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    Ref(const Ref<U>& other) : Ref(other.get()) {}
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    Ref(Ref<U>&& other) noexcept : m_ptr{other.Leak()} {}
+    ~Ref() { reset(); }
+
+    Ref& operator=(Ref other) noexcept {
+        std::swap(m_ptr, other.m_ptr);
+        return *this;
+    }
+
+    void reset() {
+        if (T* ptr = std::exchange(m_ptr, nullptr); ptr && ptr->Release())
+            delete ptr;
+    }
+
+    T*       get() const { return m_ptr; }
+    T&       operator*() const { return *m_ptr; }
+    T*       operator->() const { return m_ptr; }
+    explicit operator bool() const { return m_ptr != nullptr; }
+
+    friend bool operator==(const Ref& a, const Ref& b) {
+        return a.m_ptr == b.m_ptr;
+    }
+    friend bool operator==(const Ref& a, std::nullptr_t) { return !a.m_ptr; }
+
+   private:
+    template <typename U>
+    friend class Ref;
+
+    // Gives up the reference without releasing it
+    T* Leak() { return std::exchange(m_ptr, nullptr); }
+
+    T* m_ptr{nullptr};
+};
+
+/// A T in automatic storage that Refs may point to while it is in scope. It
+/// holds a reference of its own, so the count never drops to zero and the
+/// object is never deleted; no other reference may outlive the scope.
+template <typename T>
+class ScopedRef {
+   public:
+    template <typename... Args>
+    explicit ScopedRef(Args&&... args) : m_object(std::forward<Args>(args)...) {
+        m_object.AddRef();
+    }
+    ~ScopedRef() { assert(m_object.RefCount() == 1 && "Reference escaped"); }
+    ScopedRef(const ScopedRef&)            = delete;
+    ScopedRef& operator=(const ScopedRef&) = delete;
+
+    Ref<T> Get() { return Ref<T>(&m_object); }
+    T*     operator->() { return &m_object; }
+
+   private:
+    T m_object;
+};
+
+template <typename T, typename... Args>
+Ref<T> MakeRef(Args&&... args) {
+    return Ref<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T, typename U>
+Ref<T> StaticRefCast(const Ref<U>& ref) {
+    return Ref<T>(static_cast<T*>(ref.get()));
+}
+
+template <typename T, typename U>
+Ref<T> DynamicRefCast(const Ref<U>& ref) {
+    return Ref<T>(dynamic_cast<T*>(ref.get()));
+}
+
+}  // namespace popl::runtime
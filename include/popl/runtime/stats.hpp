@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace popl::runtime {
+
+/// Per-thread runtime counters reported by `popl --stats`.
+/// Only updated through the POPL_STATS_* macros below, which expand to nothing
+/// unless POPL_ENABLE_STATS is defined, so release builds pay nothing for them.
+struct Stats {
+    using Duration = std::chrono::steady_clock::duration;
+
+    std::uint64_t environments_created{};
+    std::uint64_t stack_environments{};  // subset of environments_created
+    std::uint64_t instances_created{};
+    std::uint64_t functions_created{};
+    std::uint64_t bound_methods_created{};  // subset of functions_created
+    std::uint64_t strings_concatenated{};
+
+    std::uint64_t live_objects{};
+    std::uint64_t peak_live_objects{};
+
+    std::uint64_t calls_executed{};
+    std::uint64_t statements_executed{};
+    std::uint64_t call_depth{};
+    std::uint64_t max_call_depth{};
+
+    // Evaluations of the Peephole pass's fused nodes
+    std::uint64_t fused_increments{};
+    std::uint64_t fused_compares{};
+    std::uint64_t fused_this_gets{};
+    // InvariantExpr evaluations served from the loop's cache
+    std::uint64_t invariants_reused{};
+    // Statements the DeadCode pass removed before execution
+    std::uint64_t statements_removed{};
+
+    Duration lex_time{};
+    Duration parse_time{};
+    Duration resolve_time{};
+    Duration optimize_time{};
+    Duration interpret_time{};
+
+    void ObjectCreated() {
+        if (++live_objects > peak_live_objects)
+            peak_live_objects = live_objects;
+    }
+    void ObjectDestroyed() { --live_objects; }
+    void EnterCall() {
+        ++calls_executed;
+        if (++call_depth > max_call_depth) max_call_depth = call_depth;
+    }
+    void ExitCall() { --call_depth; }
+
+    void Print(std::FILE* out) const;
+};
+
+Stats& GetStats();
+
+constexpr bool StatsEnabled() {
+#ifdef POPL_ENABLE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+class ScopedStatsTimer {
+   public:
+    explicit ScopedStatsTimer(Stats::Duration& target)
+        : m_target{target}, m_start{std::chrono::steady_clock::now()} {}
+    ~ScopedStatsTimer() {
+        m_target += std::chrono::steady_clock::now() - m_start;
+    }
+    ScopedStatsTimer(const ScopedStatsTimer&)            = delete;
+    ScopedStatsTimer& operator=(const ScopedStatsTimer&) = delete;
+
+   private:
+    Stats::Duration&                      m_target;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+class ScopedStatsCall {
+   public:
+    ScopedStatsCall() { GetStats().EnterCall(); }
+    ~ScopedStatsCall() { GetStats().ExitCall(); }
+    ScopedStatsCall(const ScopedStatsCall&)            = delete;
+    ScopedStatsCall& operator=(const ScopedStatsCall&) = delete;
+};
+
+}  // namespace popl::runtime
+
+#ifdef POPL_ENABLE_STATS
+#define POPL_STATS_INC(counter) (++::popl::runtime::GetStats().counter)
+#define POPL_STATS_ADD(counter, n) (::popl::runtime::GetStats().counter += (n))
+#define POPL_STATS_OBJECT_CREATED(counter)          \
+    do {                                            \
+        ++::popl::runtime::GetStats().counter;      \
+        ::popl::runtime::GetStats().ObjectCreated(); \
+    } while (false)
+#define POPL_STATS_OBJECT_DESTROYED() \
+    (::popl::runtime::GetStats().ObjectDestroyed())
+#define POPL_STATS_CALL_SCOPE() \
+    ::popl::runtime::ScopedStatsCall popl_stats_call_scope {}
+#define POPL_STATS_TIMER(duration)                                \
+    ::popl::runtime::ScopedStatsTimer popl_stats_timer_##duration{ \
+        ::popl::runtime::GetStats().duration}
+#else
+#define POPL_STATS_INC(counter)            ((void)0)
+#define POPL_STATS_ADD(counter, n)         ((void)(n))
+#define POPL_STATS_OBJECT_CREATED(counter) ((void)0)
+#define POPL_STATS_OBJECT_DESTROYED()      ((void)0)
+#define POPL_STATS_CALL_SCOPE()            ((void)0)
+#define POPL_STATS_TIMER(duration)         ((void)0)
+#endif
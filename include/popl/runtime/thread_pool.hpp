@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace popl::runtime {
+
+/// Cached thread pool for PopL workers. A thread is started whenever no idle
+/// one is available, so tasks that block on each other (e.g. through a
+/// channel) can never starve the pool; finished threads are reused. Once
+/// `max_threads` are busy further tasks are rejected rather than queued,
+/// since a queued task could wait forever on a blocked one.
+class ThreadPool {
+   public:
+    using Task = std::function<void()>;
+
+    // Enough for workers blocked on each other, well below OS thread limits
+    static constexpr std::size_t kDefaultMaxThreads = 256;
+
+    explicit ThreadPool(std::size_t max_threads = kDefaultMaxThreads)
+        : m_max_threads{max_threads} {}
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool shared by every interpreter
+    static ThreadPool& Shared();
+
+    // False, without running `task`, when every thread is busy and no more
+    // can be started
+    [[nodiscard]] bool Submit(Task task);
+
+   private:
+    void WorkerLoop();
+
+   private:
+    std::mutex               m_mutex;
+    std::condition_variable  m_has_task;
+    std::deque<Task>         m_tasks{};
+    std::vector<std::thread> m_threads{};
+    std::size_t              m_max_threads;
+    std::size_t              m_idle{0};
+    bool                     m_stopping{false};
+};
+
+}  // namespace popl::runtime
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace popl::runtime {
+
+enum class TraceCategory : std::uint8_t { PHASE, POPL_CALL, NATIVE_CALL };
+
+/// Records begin/end duration events and writes them in the Chrome
+/// trace-event JSON format (loadable in chrome://tracing and Perfetto).
+/// Events are appended to an in-memory buffer with interned names and are only
+/// serialized by Write(), so recording stays cheap on the hot call path.
+class Tracer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    Tracer();
+
+    void Begin(std::string_view name, TraceCategory category);
+    void End();
+
+    // Throws std::runtime_error if the file can't be written
+    void Write(const std::string& path) const;
+
+   private:
+    struct Event {
+        std::uint64_t timestamp_ns;
+        std::uint32_t name_id;
+        TraceCategory category;
+        char          phase;  // 'B' or 'E'
+    };
+    struct StringHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const {
+            return std::hash<std::string_view>{}(s);
+        }
+    };
+
+    std::uint32_t Intern(std::string_view name);
+    std::uint64_t Now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now() - m_start)
+            .count();
+    }
+
+   private:
+    Clock::time_point          m_start;
+    std::vector<Event>         m_events{};
+    std::vector<Event>         m_open{};  // unfinished Begin()s
+    std::vector<std::string>   m_names{};
+    std::unordered_map<std::string, std::uint32_t, StringHash, std::equal_to<>>
+        m_name_ids{};
+};
+
+/// RAII helper emitting a Begin/End pair; a null tracer makes it a no-op.
+class TraceScope {
+   public:
+    TraceScope(Tracer* tracer, std::string_view name, TraceCategory category)
+        : m_tracer{tracer} {
+        if (m_tracer) m_tracer->Begin(name, category);
+    }
+    ~TraceScope() {
+        if (m_tracer) m_tracer->End();
+    }
+    TraceScope(const TraceScope&)            = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+   private:
+    Tracer* m_tracer;
+};
+
+}  // namespace popl::runtime
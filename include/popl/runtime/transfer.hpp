@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "popl/environment.hpp"
+#include "popl/literal.hpp"
+
+namespace popl {
+class Interpreter;
+}
+
+namespace popl::runtime {
+
+/// Deep copy of PopL values that shares no mutable object with any
+/// interpreter, so it can be handed to another thread. Functions keep pointing
+/// at the (immutable) AST, so it must not outlive the program that produced
+/// it. The owner's global environment is replaced by `globals`, which is
+/// rebound to the receiving interpreter's globals on Attach().
+struct DetachedGraph {
+    std::vector<PopLObject> values{};
+    Ref<Environment>        globals{Environment::Make()};
+};
+
+// Copies `values` out of `from`; with `with_globals` the sender's global
+// variables are snapshotted too and defined in the receiver on Attach()
+DetachedGraph Detach(Interpreter& from, const std::vector<PopLObject>& values,
+                     bool with_globals = false);
+// Copies the graph into `to`, returning the copies of the detached values
+std::vector<PopLObject> Attach(Interpreter& to, const DetachedGraph& graph);
+
+// Copies values straight from `from` into `to`, on the thread that runs `to`;
+// `from` must be idle
+std::vector<PopLObject> Transfer(Interpreter& from, Interpreter& to,
+                                 const std::vector<PopLObject>& values);
+
+class GraphCopier;
+
+/// Attach() one value at a time, for graphs too large to copy up front. Only
+/// reads `graph`, so several threads may attach from the same graph.
+class Attacher {
+   public:
+    // Defines the graph's global snapshot in `to`; `graph` must outlive this
+    Attacher(Interpreter& to, const DetachedGraph& graph);
+    ~Attacher();
+
+    // `value` must be reachable from `graph`
+    PopLObject Copy(const PopLObject& value);
+
+   private:
+    std::unique_ptr<GraphCopier> m_copier;
+};
+
+}  // namespace popl::runtime
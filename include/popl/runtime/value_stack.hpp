@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "popl/literal.hpp"
+
+namespace popl::runtime {
+
+/// Stack that call arguments are evaluated onto, so that callees can read
+/// them as a span without a vector being allocated per call. Storage is a list
+/// of fixed-capacity segments that never reallocate, which keeps the spans
+/// handed out stable while nested calls push their own arguments.
+class ValueStack {
+   public:
+    static constexpr std::size_t kSegmentSize = 256;
+
+    /// The arguments of one call. Frames must be released in LIFO order,
+    /// which holding them in local variables guarantees.
+    class Frame {
+       public:
+        // Reserves room for `count` contiguous values
+        Frame(ValueStack& stack, std::size_t count)
+            : m_stack{stack}, m_previous{stack.m_current} {
+            m_segment = &stack.Reserve(count);
+            m_begin   = m_segment->size();
+        }
+        ~Frame() {
+            m_segment->erase(m_segment->begin() + m_begin, m_segment->end());
+            m_stack.m_current = m_previous;
+        }
+        Frame(const Frame&)            = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        // At most `count` values may be pushed
+        void Push(PopLObject value) {
+            assert(m_segment->size() < m_segment->capacity());
+            m_segment->push_back(std::move(value));
+        }
+        std::span<const PopLObject> Args() const {
+            return {m_segment->data() + m_begin, m_segment->size() - m_begin};
+        }
+
+       private:
+        ValueStack&              m_stack;
+        std::vector<PopLObject>* m_segment;
+        std::size_t              m_begin;
+        std::size_t              m_previous;
+    };
+
+   private:
+    // Segment with room for `count` more values, moving past the current one
+    // when it is too full
+    std::vector<PopLObject>& Reserve(std::size_t count) {
+        if (m_segments.empty()) AddSegment(count);
+        auto& current = m_segments[m_current];
+        if (current.capacity() - current.size() >= count) return current;
+        if (++m_current == m_segments.size()) AddSegment(count);
+        auto& next = m_segments[m_current];
+        // Segments past the current one are empty, so this never moves a
+        // live value
+        if (next.capacity() < count) next.reserve(count);
+        return next;
+    }
+    void AddSegment(std::size_t count) {
+        m_segments.emplace_back().reserve(std::max(kSegmentSize, count));
+    }
+
+   private:
+    // A deque never moves its elements, so frames may point into it
+    std::deque<std::vector<PopLObject>> m_segments{};
+    std::size_t                         m_current{0};
+};
+
+}  // namespace popl::runtime
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace popl::runtime {
+
+/// Loops over raw double arrays behind the Float64Array natives. Get() picks
+/// the widest implementation the CPU supports (AVX2+FMA, SSE2, or plain
+/// loops) once at startup. Reductions keep several partial sums, so their
+/// rounding may differ from a left-to-right loop.
+struct VectorKernels {
+    std::string_view isa;
+
+    double (*sum)(const double* x, std::size_t n);
+    double (*dot)(const double* x, const double* y, std::size_t n);
+    // y = alpha * x + y
+    void (*axpy)(double alpha, const double* x, double* y, std::size_t n);
+    // out = x + y and out = x * y; `out` may alias either input
+    void (*add)(const double* x, const double* y, double* out, std::size_t n);
+    void (*mul)(const double* x, const double* y, double* out, std::size_t n);
+    // n must be positive
+    double (*min)(const double* x, std::size_t n);
+    double (*max)(const double* x, std::size_t n);
+    // out[i] = x[0] + ... + x[i]; `out` may alias `x`
+    void (*prefix_sum)(const double* x, double* out, std::size_t n);
+
+    static const VectorKernels& Get();
+};
+
+}  // namespace popl::runtime
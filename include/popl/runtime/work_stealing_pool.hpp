@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "popl/runtime/thread_pool.hpp"
+
+namespace popl::runtime {
+
+/// Data-parallel loops over an index range. The range is cut into chunks that
+/// are dealt out to one queue per participant; a participant that runs out of
+/// work steals chunks from the back of the others' queues.
+class WorkStealingPool {
+   public:
+    // Receives the participant number (< Concurrency()) and a chunk
+    using Body = std::function<void(unsigned participant, std::size_t begin,
+                                    std::size_t end)>;
+
+    // One participant per hardware thread, the calling thread included
+    explicit WorkStealingPool(unsigned threads);
+    static WorkStealingPool& Shared();
+
+    unsigned Concurrency() const { return m_concurrency; }
+
+    // Runs `body` over [0, count) in chunks of at most `grain` indices and
+    // returns once every chunk is done. The first exception thrown by `body`
+    // cancels the remaining chunks and is rethrown here. Participants that
+    // are still queued when the caller has finished the work are dropped, so
+    // nested loops cannot deadlock the pool.
+    void ParallelFor(std::size_t count, std::size_t grain, const Body& body);
+
+   private:
+    struct Job;
+
+    static void Participate(Job& job, unsigned participant);
+
+   private:
+    unsigned   m_concurrency;
+    ThreadPool m_threads{};
+};
+
+}  // namespace popl::runtime
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "popl/literal.hpp"
+#include "popl/runtime/transfer.hpp"
+
+namespace popl {
+class Interpreter;
+}
+
+namespace popl::runtime {
+
+/// Bounded FIFO of detached values between interpreters on different threads.
+class Channel {
+   public:
+    explicit Channel(std::size_t capacity) : m_capacity{capacity} {}
+
+    // Blocks while the channel is full; returns false once it is closed
+    bool Send(DetachedGraph value);
+    // Blocks while the channel is empty; returns nullopt once it is closed and
+    // drained
+    std::optional<DetachedGraph> Receive();
+    void                         Close();
+
+   private:
+    std::mutex                m_mutex;
+    std::condition_variable   m_not_empty;
+    std::condition_variable   m_not_full;
+    std::deque<DetachedGraph> m_queue{};
+    std::size_t               m_capacity;
+    bool                      m_closed{false};
+};
+
+/// Workers and channels created by one script, shared by the interpreter
+/// that runs it and by every worker interpreter it spawns.
+class WorkerGroup : public std::enable_shared_from_this<WorkerGroup> {
+   public:
+    using Id     = std::uint32_t;
+    // The worker's detached return value, or the message of its runtime error
+    using Result = std::expected<DetachedGraph, std::string>;
+
+    // Calls `callee(arg)` on a pool thread in a new interpreter that starts
+    // with a copy of the parent's globals and what is left of its budget;
+    // nullopt when the pool has no thread left to run it on
+    std::optional<Id> Spawn(Interpreter& parent, const PopLObject& callee,
+                            const PopLObject& arg);
+    // Waits for the worker; nullopt if `id` is unknown or already joined
+    std::optional<Result> Join(Id id);
+
+    Id                       NewChannel(std::size_t capacity);
+    // nullptr if `id` is unknown
+    std::shared_ptr<Channel> GetChannel(Id id) const;
+
+    // Closes every channel, so workers blocked in receive() wake up, and waits
+    // for all workers that were not joined, discarding their results
+    void Shutdown();
+
+   private:
+    mutable std::mutex                               m_mutex;
+    std::unordered_map<Id, std::future<Result>>      m_workers{};
+    std::unordered_map<Id, std::shared_ptr<Channel>> m_channels{};
+    Id                                               m_next_worker{1};
+    Id                                               m_next_channel{1};
+};
+
+}  // namespace popl::runtime
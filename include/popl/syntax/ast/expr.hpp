@@ -46,9 +46,12 @@ struct CallExpr {
     std::vector<std::unique_ptr<Expr>> arguments;
 };
 
+// Variables are resolved to a local `depth` environments up, to an upvalue
+// (captured variable) of the running closure, or else to a global
 struct VariableExpr {
     Token              name;
     std::optional<int> depth;
+    std::optional<int> upvalue;
 };
 
 struct LogicalExpr {
@@ -57,9 +60,20 @@ struct LogicalExpr {
     std::unique_ptr<Expr> right;
 };
 
+// A variable that a closure captures when it is created: a local `index`
+// environments up from where the closure is created, or else upvalue
+// `index` of the closure creating it
+struct Upvalue {
+    Token name;
+    bool  isLocal;
+    int   index;
+};
+
 struct FunctionExpr {
     std::vector<Token>                 params;
     std::vector<std::unique_ptr<Stmt>> body;
+    // Filled in by the Resolver
+    std::vector<Upvalue>               upvalues;
 };
 
 struct GetExpr {
@@ -71,6 +85,7 @@ struct AssignExpr {
     Token                 name;
     std::unique_ptr<Expr> value;
     std::optional<int>    depth;
+    std::optional<int>    upvalue;
 };
 
 struct SetExpr {
@@ -82,13 +97,78 @@ struct SetExpr {
 struct ThisExpr {
     Token              keyword;
     std::optional<int> depth;
+    std::optional<int> upvalue;
+};
+
+struct ArrayExpr {
+    Token                              bracket;
+    std::vector<std::unique_ptr<Expr>> elements;
+};
+
+struct IndexExpr {
+    std::unique_ptr<Expr> object;
+    Token                 bracket;
+    std::unique_ptr<Expr> index;
+};
+
+struct IndexSetExpr {
+    std::unique_ptr<Expr> object;
+    Token                 bracket;
+    std::unique_ptr<Expr> index;
+    std::unique_ptr<Expr> value;
+};
+
+struct MapExpr {
+    Token                              brace;
+    std::vector<std::unique_ptr<Expr>> keys;
+    std::vector<std::unique_ptr<Expr>> values;
+};
+
+/*
+ * Fused nodes: the Peephole pass rewrites common shapes of resolved trees into
+ * these, which are evaluated without visiting the nodes they replace. The
+ * parser never produces them.
+ */
+
+// `name = name + constant` or `name = name - constant`
+struct IncrementExpr {
+    Token              name;
+    Token              op;
+    double             constant;
+    std::optional<int> depth;
+    std::optional<int> upvalue;
+};
+
+// `left < right` or another ordering, where `right` is a variable or else
+// the number `constant`
+struct CompareExpr {
+    VariableExpr                left;
+    Token                       op;
+    std::optional<VariableExpr> right;
+    double                      constant;
+};
+
+// `this.name`
+struct ThisGetExpr {
+    ThisExpr object;
+    Token    name;
+};
+
+// An expression the LoopInvariants pass found not to change while the
+// innermost enclosing loop runs. It is evaluated on first use in each run of
+// the loop and then read from the loop's cache `slot`.
+struct InvariantExpr {
+    std::unique_ptr<Expr> expression;
+    int                   slot;
 };
 
 struct Expr {
-    using Variant = std::variant<NilExpr, BinaryExpr, TernaryExpr, GroupingExpr,
-                                 LiteralExpr, UnaryExpr, CallExpr, VariableExpr,
-                                 LogicalExpr, FunctionExpr, GetExpr, AssignExpr,
-                                 SetExpr, ThisExpr>;
+    using Variant =
+        std::variant<NilExpr, BinaryExpr, TernaryExpr, GroupingExpr,
+                     LiteralExpr, UnaryExpr, CallExpr, VariableExpr,
+                     LogicalExpr, FunctionExpr, GetExpr, AssignExpr, SetExpr,
+                     ThisExpr, ArrayExpr, IndexExpr, IndexSetExpr, MapExpr,
+                     IncrementExpr, CompareExpr, ThisGetExpr, InvariantExpr>;
 
     Variant node;
 };
@@ -34,6 +34,8 @@ struct IfStmt {
 struct WhileStmt {
     std::unique_ptr<Expr> condition;
     std::unique_ptr<Stmt> body;
+    // Cache slots of the InvariantExprs in the loop, set by LoopInvariants
+    int                   invariants{0};
 };
 
 struct BreakStmt {
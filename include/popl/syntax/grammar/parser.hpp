@@ -17,7 +17,8 @@ class ParseError : public std::runtime_error {
 };
 class Parser {
    public:
-    Parser(std::vector<Token> tokens) : m_tokens{std::move(tokens)} {}
+    Parser(std::vector<Token> tokens, Diagnostics& diagnostics)
+        : m_tokens{std::move(tokens)}, m_diagnostics{diagnostics} {}
     std::vector<std::unique_ptr<Stmt>> Parse();
 
    private:
@@ -58,7 +59,7 @@ class Parser {
         return std::make_unique<Stmt>(std::move(stmt));
     }
     ParseError Error(Token token, const std::string& message) {
-        Diagnostics::Error(token, message);
+        m_diagnostics.Error(token, message);
         return ParseError{};
     }
     void Synchronize();
@@ -94,6 +95,8 @@ class Parser {
     CallExpr FinishCall(Expr callee);
     Expr     Primary();
     Expr     AnonymousFunction();
+    Expr     ArrayLiteral();
+    Expr     MapLiteral();
 
     template <typename ExprType = BinaryExpr, typename SubParser>
     Expr ParseBinary(SubParser&&                      parseOperand,
@@ -101,6 +104,7 @@ class Parser {
 
    private:
     std::vector<Token> m_tokens{};
+    Diagnostics&       m_diagnostics;
     int                m_current{};
 };
 
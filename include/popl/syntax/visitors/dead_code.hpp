@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "popl/syntax/ast/expr.hpp"
+#include "popl/syntax/ast/stmt.hpp"
+
+namespace popl {
+
+/// Removes code that can never run or never be reached by name from resolved
+/// trees: statements after a `return`, `break` or `continue`, branches and
+/// loops whose condition is a literal, and top-level functions and classes
+/// that nothing reads or assigns. Globals are the names the Resolver left
+/// unresolved. A REPL batch keeps its top-level declarations, which later
+/// batches may use.
+class DeadCode {
+   public:
+    explicit DeadCode(bool replMode);
+
+    void Optimize(std::vector<std::unique_ptr<Stmt>>& statements);
+
+    //  Statement visitors; a visitor may replace `originalStmt`
+    void operator()(ExpressionStmt& stmt, Stmt& originalStmt);
+    void operator()(NilStmt& stmt, Stmt&);
+    void operator()(VarStmt& stmt, Stmt&);
+    void operator()(BlockStmt& stmt, Stmt&);
+    void operator()(IfStmt& stmt, Stmt&);
+    void operator()(WhileStmt& stmt, Stmt&);
+    void operator()(BreakStmt& stmt, Stmt&);
+    void operator()(ContinueStmt& stmt, Stmt&);
+    void operator()(ReturnStmt& stmt, Stmt&);
+    void operator()(FunctionStmt& stmt, Stmt&);
+    void operator()(ClassStmt& stmt, Stmt&);
+
+    //  Expression visitors; a visitor may replace `originalExpr`
+    void operator()(LiteralExpr& expr, Expr& originalExpr);
+    void operator()(GroupingExpr& expr, Expr&);
+    void operator()(TernaryExpr& expr, Expr&);
+    void operator()(UnaryExpr& expr, Expr&);
+    void operator()(BinaryExpr& expr, Expr&);
+    void operator()(VariableExpr& expr, Expr&);
+    void operator()(NilExpr& expr, Expr&);
+    void operator()(LogicalExpr& expr, Expr&);
+    void operator()(CallExpr& expr, Expr&);
+    void operator()(AssignExpr& expr, Expr&);
+    void operator()(FunctionExpr& expr, Expr&);
+    void operator()(GetExpr& expr, Expr&);
+    void operator()(SetExpr& expr, Expr&);
+    void operator()(ThisExpr& expr, Expr&);
+    void operator()(ArrayExpr& expr, Expr&);
+    void operator()(IndexExpr& expr, Expr&);
+    void operator()(IndexSetExpr& expr, Expr&);
+    void operator()(MapExpr& expr, Expr&);
+    void operator()(IncrementExpr& expr, Expr&);
+    void operator()(CompareExpr& expr, Expr&);
+    void operator()(ThisGetExpr& expr, Expr&);
+    void operator()(InvariantExpr& expr, Expr&);
+
+   private:
+    using Names = std::unordered_set<std::string>;
+    // Globals referred to by each top-level declaration
+    using Uses = std::unordered_map<const Stmt*, Names>;
+
+    void Optimize(Stmt& stmt);
+    void Optimize(Expr& expr);
+    // Optimizes a block's statements and drops the ones after the first that
+    // never completes normally
+    void OptimizeBlock(std::vector<std::unique_ptr<Stmt>>& statements);
+    // Drops the top-level declarations in `uses` that are not reachable from
+    // the globals in `live`
+    void RemoveUnused(std::vector<std::unique_ptr<Stmt>>& statements,
+                      Names live, const Uses& uses);
+
+    // Records a read or assignment of `name` if it resolved to a global
+    void Reference(const Token& name, const std::optional<int>& depth,
+                   const std::optional<int>& upvalue);
+
+   private:
+    bool m_repl_mode;
+    // Globals referred to by the code being walked: the current top-level
+    // declaration, or else the rest of the batch
+    Names* m_references{nullptr};
+};
+
+}  // namespace popl
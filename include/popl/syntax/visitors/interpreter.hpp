@@ -1,29 +1,110 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 
 #include "popl/callables/native_registry.hpp"
+#include "popl/diagnostics.hpp"
 #include "popl/environment.hpp"
 #include "popl/literal.hpp"
+#include "popl/runtime/event_loop.hpp"
+#include "popl/runtime/file_table.hpp"
+#include "popl/runtime/limits.hpp"
+#include "popl/runtime/object_pool.hpp"
+#include "popl/runtime/output_buffer.hpp"
+#include "popl/runtime/run_time_error.hpp"
+#include "popl/runtime/tracer.hpp"
+#include "popl/runtime/value_stack.hpp"
 #include "popl/syntax/ast/expr.hpp"
 #include "popl/syntax/ast/stmt.hpp"
 
 namespace popl {
 
+namespace runtime {
+class WorkerGroup;
+}
+
+/// One isolated PopL engine: owns its globals, natives and diagnostics sink.
+/// Separate instances share no mutable state and may run on separate threads;
+/// a single instance must only be used by one thread at a time.
 class Interpreter {
    public:
-    Interpreter()
-        : m_global_environment{std::make_shared<Environment>()},
-          m_current_environment{m_global_environment} {
+    explicit Interpreter(Diagnostics diagnostics = Diagnostics{})
+        : m_diagnostics{diagnostics} {
+        // Globals and natives come from this interpreter's pool even when it
+        // is created while another one is running
+        runtime::CurrentPoolScope pool_scope{m_pool.get()};
+        m_global_environment  = Environment::Make();
+        m_current_environment = m_global_environment;
         NativeRegistry::RegisterAll(*this);
     }
+    ~Interpreter();
+    Interpreter(const Interpreter&)            = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // Runs the event loop once the statements are done and, outside the REPL,
+    // waits for the script's workers before returning
     void Interpret(std::vector<std::unique_ptr<Stmt>>& statements,
                    bool                                replMode);
-    std::shared_ptr<Environment> GetGlobalEnvironment() {
+    // Entry point for worker threads: calls `callee` (which must accept
+    // `args`) and then runs the event loop; runtime errors propagate. The
+    // budget is not reset, see InheritBudget()
+    PopLObject CallFunction(const PopLObject&           callee,
+                            std::span<const PopLObject> args);
+    // Calls `callee` back from the native `native`, e.g. map()'s callback,
+    // with the depth limit and accounting of a call expression; `callee` must
+    // accept `args`
+    PopLObject CallBack(std::string_view               native,
+                        const PopLObject::CallablePtr& callee,
+                        std::span<const PopLObject>    args);
+    const runtime::Ref<Environment>& GetGlobalEnvironment() const {
         return m_global_environment;
     }
+    Diagnostics&       GetDiagnostics() { return m_diagnostics; }
+    const Diagnostics& GetDiagnostics() const { return m_diagnostics; }
+    // nullptr disables tracing; the tracer must outlive the interpreter's use
+    void             SetTracer(runtime::Tracer* tracer) { m_tracer = tracer; }
+    runtime::Tracer* GetTracer() const { return m_tracer; }
+    // Applies to subsequent Interpret() calls
+    void SetLimits(const runtime::ResourceLimits& limits) {
+        m_meter.SetLimits(limits);
+    }
+    const runtime::ResourceLimits& GetLimits() const {
+        return m_meter.GetLimits();
+    }
+    const runtime::ResourceMeter& GetMeter() const { return m_meter; }
+    // Makes the calls of a worker interpreter charge the budget of the run
+    // that `parent` meters, which it shares with every other such worker
+    void InheritBudget(const runtime::ResourceMeter& parent) {
+        m_meter.Inherit(parent);
+    }
+    // Raises the allocation limit error if `bytes` more would not fit; natives
+    // call it before allocating a size the script chose
+    void CheckAlloc(std::size_t bytes) const {
+        if (!m_meter.Fits(bytes))
+            throw LimitError(runtime::ResourceMeter::Exceeded::ALLOCATION);
+    }
+    // Where subsequent runs allocate environments, functions and instances;
+    // objects already allocated keep their old pool alive
+    void SetAllocationStrategy(runtime::ObjectPool::Strategy strategy) {
+        m_pool = runtime::MakeRef<runtime::ObjectPool>(strategy);
+    }
+    // Workers and channels of the running script, created on first use
+    runtime::WorkerGroup& GetWorkerGroup();
+    // Makes this a worker interpreter sharing `group` with its parent
+    void JoinWorkerGroup(std::shared_ptr<runtime::WorkerGroup> group);
+    // Loop for async natives, created on first use
+    runtime::EventLoop& GetEventLoop();
+    // Standard output of the script; flushed after each Interpret()
+    runtime::OutputBuffer& GetOutput() { return m_output; }
+    // Files opened by the script; their writes are flushed with the output
+    runtime::FileTable& GetFiles() { return m_files; }
     void ExecuteBlock(const std::vector<std::unique_ptr<Stmt>>& stmts,
-                      std::shared_ptr<Environment>              newEnv);
+                      runtime::Ref<Environment>                 newEnv);
+    // ExecuteBlock() for a call, with `upvalues` as the captured variables
+    void ExecuteFunction(const std::vector<std::unique_ptr<Stmt>>& body,
+                         runtime::Ref<Environment>                 env,
+                         std::span<const runtime::Ref<Cell>>       upvalues);
     // Expr must be guaranteed to be alive when the interpreter visits it in
     // future
     void Resolve(const Expr& expr, int depth);
@@ -60,24 +141,79 @@ class Interpreter {
     PopLObject operator()(const ThisExpr& expr, const Expr&) const;
     PopLObject operator()(const GetExpr& expr, const Expr&);
     PopLObject operator()(const SetExpr& expr, const Expr&);
+    PopLObject operator()(const ArrayExpr& expr, const Expr&);
+    PopLObject operator()(const IndexExpr& expr, const Expr&);
+    PopLObject operator()(const IndexSetExpr& expr, const Expr&);
+    PopLObject operator()(const MapExpr& expr, const Expr&);
+    PopLObject operator()(const IncrementExpr& expr, const Expr&);
+    PopLObject operator()(const CompareExpr& expr, const Expr&);
+    PopLObject operator()(const ThisGetExpr& expr, const Expr&);
+    PopLObject operator()(const InvariantExpr& expr, const Expr&);
 
    private:
+    // Value of an InvariantExpr in the running loop, valid while m_effects is
+    // unchanged
+    struct InvariantSlot {
+        PopLObject    value{NilValue{}};
+        std::uint64_t effects{0};
+        bool          cached{false};
+    };
+
     PopLObject Evaluate(const Expr& expr);
     void       Execute(Stmt& stmt);
+    // Calls `callee` under the call-depth limit; errors point at `where`
+    PopLObject Call(const Token& where, const PopLObject::CallablePtr& callee,
+                    std::span<const PopLObject> args);
+    // The variable a resolved node refers to
+    PopLObject& Variable(const Token& name, const std::optional<int>& depth,
+                         const std::optional<int>& upvalue) const;
+    PopLObject  BinaryOperation(const Token& op, const PopLObject& left,
+                                const PopLObject& right) const;
     void  CheckNumberOperand(const Token& op, const PopLObject& operand) const;
     void  CheckNumberOperand(const Token& op, const PopLObject& left,
                              const PopLObject& right) const;
     void  CheckUninitialised(const Token& op, const PopLObject& value) const;
+    void  CheckKey(const Token& op, const PopLObject& key) const;
+    // Returns `index` as a position in an array of `size` elements
+    std::size_t CheckIndex(const Token& bracket, std::size_t size,
+                           const PopLObject& index) const;
     Token MakeReplReadToken(std::string_view what = "<repl>") const;
+    void  CheckLimits();
+    runtime::RunTimeError LimitError(
+        runtime::ResourceMeter::Exceeded exceeded) const;
+    // Runs the event loop, if there is one; waiting on it past the time
+    // limit is a limit error like running past it
+    void  RunEventLoop();
     const PopLObject& LookUpVariable(const Token& name, const Expr& expr) const;
+    // The cells a closure of `function` created now captures
+    Upvalues CaptureUpvalues(const FunctionExpr& function);
 
    private:
-    std::shared_ptr<Environment>         m_global_environment{};
-    std::shared_ptr<Environment>         m_current_environment{};
+    Diagnostics                           m_diagnostics;
+    runtime::Ref<runtime::ObjectPool>     m_pool{
+        runtime::MakeRef<runtime::ObjectPool>()};
+    runtime::Ref<Environment>             m_global_environment{};
+    runtime::Ref<Environment>             m_current_environment{};
+    // Captured variables of the running closure
+    std::span<const runtime::Ref<Cell>>   m_upvalues{};
+    // Invariant values of the innermost running loop
+    std::span<InvariantSlot>              m_invariants{};
+    // Number of impure calls made so far; any of them may have changed what
+    // an invariant expression read
+    std::uint64_t                         m_effects{0};
     // function etc. which need to be kept at the same location after resolving
     // and can't be deleted till program termination
-    std::vector<std::unique_ptr<Stmt>>   m_persistent_statements{};
-    std::unordered_map<const Expr*, int> m_locals{};
-    bool                                 m_repl_mode{false};
+    std::vector<std::unique_ptr<Stmt>>    m_persistent_statements{};
+    std::unordered_map<const Expr*, int>  m_locals{};
+    bool                                  m_repl_mode{false};
+    runtime::Tracer*                      m_tracer{nullptr};
+    runtime::ResourceMeter                m_meter{};
+    std::uint32_t                         m_call_depth{0};
+    std::shared_ptr<runtime::WorkerGroup> m_worker_group{};
+    bool                                  m_owns_worker_group{false};
+    std::unique_ptr<runtime::EventLoop>   m_event_loop{};
+    runtime::ValueStack                   m_value_stack{};
+    runtime::OutputBuffer                 m_output{};
+    runtime::FileTable                    m_files{};
 };
 };  // namespace popl
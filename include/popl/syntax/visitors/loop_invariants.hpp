@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "popl/syntax/ast/expr.hpp"
+#include "popl/syntax/ast/stmt.hpp"
+
+namespace popl {
+
+class Environment;
+class Interpreter;
+
+/// Loop-invariant code motion over resolved trees. In a loop that calls
+/// nothing but pure natives, expressions that read only variables the loop
+/// never assigns are wrapped in InvariantExprs. Property and index reads and
+/// native calls also require that the loop stores no properties or elements.
+/// The interpreter evaluates each InvariantExpr once per run of its loop, on
+/// first use, so errors are raised exactly where they would have been; it
+/// drops the cached values whenever an impure call runs, e.g. a native that
+/// the script replaced by a function of its own.
+class LoopInvariants {
+   public:
+    // Natives are looked up in the interpreter's globals
+    explicit LoopInvariants(const Interpreter& interpreter);
+
+    void Optimize(std::vector<std::unique_ptr<Stmt>>& statements);
+
+    //  Statement visitors
+    void operator()(ExpressionStmt& stmt, Stmt& originalStmt);
+    void operator()(NilStmt& stmt, Stmt&);
+    void operator()(VarStmt& stmt, Stmt&);
+    void operator()(BlockStmt& stmt, Stmt&);
+    void operator()(IfStmt& stmt, Stmt&);
+    void operator()(WhileStmt& stmt, Stmt&);
+    void operator()(BreakStmt& stmt, Stmt&);
+    void operator()(ContinueStmt& stmt, Stmt&);
+    void operator()(ReturnStmt& stmt, Stmt&);
+    void operator()(FunctionStmt& stmt, Stmt&);
+    void operator()(ClassStmt& stmt, Stmt&);
+
+    //  Expression visitors
+    void operator()(LiteralExpr& expr, Expr& originalExpr);
+    void operator()(GroupingExpr& expr, Expr&);
+    void operator()(TernaryExpr& expr, Expr&);
+    void operator()(UnaryExpr& expr, Expr&);
+    void operator()(BinaryExpr& expr, Expr&);
+    void operator()(VariableExpr& expr, Expr&);
+    void operator()(NilExpr& expr, Expr&);
+    void operator()(LogicalExpr& expr, Expr&);
+    void operator()(CallExpr& expr, Expr&);
+    void operator()(AssignExpr& expr, Expr&);
+    void operator()(FunctionExpr& expr, Expr&);
+    void operator()(GetExpr& expr, Expr&);
+    void operator()(SetExpr& expr, Expr&);
+    void operator()(ThisExpr& expr, Expr&);
+    void operator()(ArrayExpr& expr, Expr&);
+    void operator()(IndexExpr& expr, Expr&);
+    void operator()(IndexSetExpr& expr, Expr&);
+    void operator()(MapExpr& expr, Expr&);
+    void operator()(IncrementExpr& expr, Expr&);
+    void operator()(CompareExpr& expr, Expr&);
+    void operator()(ThisGetExpr& expr, Expr&);
+    void operator()(InvariantExpr& expr, Expr&);
+
+    // What a loop may change while it runs, collected from its condition and
+    // body, including nested loops and functions
+    struct Effects {
+        std::unordered_set<std::string> assigned{};  // or declared
+        std::vector<const CallExpr*>    calls{};
+        bool                            stores{false};
+    };
+
+   private:
+    // The loop whose invariants are being hoisted
+    struct Loop {
+        Effects effects;
+        int     slots{0};
+    };
+
+    void Optimize(Stmt& stmt);
+    void Optimize(Expr& expr);
+    // Wraps `expr` when it is invariant in the current loop, or else looks
+    // for invariants inside it
+    void Hoist(Expr& expr);
+    // Optimizes a function body, which runs outside of any loop around it
+    void OptimizeFunction(FunctionExpr& function);
+
+    bool IsInvariant(const Expr& expr) const;
+    bool IsPureNative(const Expr& callee) const;
+
+   private:
+    const Environment& m_globals;
+    // Globals the script assigns or declares, which may no longer hold the
+    // natives they start with
+    std::unordered_set<std::string> m_rebound{};
+    Loop*                           m_loop{nullptr};
+};
+
+}  // namespace popl
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "popl/syntax/ast/expr.hpp"
+#include "popl/syntax/ast/stmt.hpp"
+
+namespace popl {
+
+/// Rewrites common shapes of resolved trees into the fused nodes of expr.hpp:
+/// `i = i + c` into IncrementExpr, `i < n` into CompareExpr and `this.x` into
+/// ThisGetExpr. Must run after the Resolver, whose annotations it carries
+/// over; the rewritten tree behaves exactly like the original.
+class Peephole {
+   public:
+    void Optimize(std::vector<std::unique_ptr<Stmt>>& statements);
+
+    //  Statement visitors
+    void operator()(ExpressionStmt& stmt, Stmt& originalStmt);
+    void operator()(NilStmt& stmt, Stmt&);
+    void operator()(VarStmt& stmt, Stmt&);
+    void operator()(BlockStmt& stmt, Stmt&);
+    void operator()(IfStmt& stmt, Stmt&);
+    void operator()(WhileStmt& stmt, Stmt&);
+    void operator()(BreakStmt& stmt, Stmt&);
+    void operator()(ContinueStmt& stmt, Stmt&);
+    void operator()(ReturnStmt& stmt, Stmt&);
+    void operator()(FunctionStmt& stmt, Stmt&);
+    void operator()(ClassStmt& stmt, Stmt&);
+
+    //  Expression visitors; a visitor may replace `originalExpr`
+    void operator()(LiteralExpr& expr, Expr& originalExpr);
+    void operator()(GroupingExpr& expr, Expr&);
+    void operator()(TernaryExpr& expr, Expr&);
+    void operator()(UnaryExpr& expr, Expr&);
+    void operator()(BinaryExpr& expr, Expr&);
+    void operator()(VariableExpr& expr, Expr&);
+    void operator()(NilExpr& expr, Expr&);
+    void operator()(LogicalExpr& expr, Expr&);
+    void operator()(CallExpr& expr, Expr&);
+    void operator()(AssignExpr& expr, Expr&);
+    void operator()(FunctionExpr& expr, Expr&);
+    void operator()(GetExpr& expr, Expr&);
+    void operator()(SetExpr& expr, Expr&);
+    void operator()(ThisExpr& expr, Expr&);
+    void operator()(ArrayExpr& expr, Expr&);
+    void operator()(IndexExpr& expr, Expr&);
+    void operator()(IndexSetExpr& expr, Expr&);
+    void operator()(MapExpr& expr, Expr&);
+    void operator()(IncrementExpr& expr, Expr&);
+    void operator()(CompareExpr& expr, Expr&);
+    void operator()(ThisGetExpr& expr, Expr&);
+    void operator()(InvariantExpr& expr, Expr&);
+
+   private:
+    void Optimize(Stmt& stmt);
+    void Optimize(Expr& expr);
+};
+
+}  // namespace popl
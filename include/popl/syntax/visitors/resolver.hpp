@@ -4,11 +4,12 @@
 
 namespace popl {
 
+class Diagnostics;
 class Interpreter;
 
 class Resolver {
    public:
-    Resolver(Interpreter& interpreter) : m_interpreter{interpreter} {}
+    Resolver(Interpreter& interpreter);
 
     void Resolve(std::vector<std::unique_ptr<Stmt>>& statements);
 
@@ -40,6 +41,14 @@ class Resolver {
     void operator()(GetExpr& expr, Expr&);
     void operator()(SetExpr& expr, Expr&);
     void operator()(ThisExpr& expr, Expr&);
+    void operator()(ArrayExpr& expr, Expr&);
+    void operator()(IndexExpr& expr, Expr&);
+    void operator()(IndexSetExpr& expr, Expr&);
+    void operator()(MapExpr& expr, Expr&);
+    void operator()(IncrementExpr& expr, Expr&);
+    void operator()(CompareExpr& expr, Expr&);
+    void operator()(ThisGetExpr& expr, Expr&);
+    void operator()(InvariantExpr& expr, Expr&);
 
    private:
     enum class FunctionType { NONE, FUNCTION, METHOD, INITIALIZER };
@@ -52,32 +61,50 @@ class Resolver {
     };
     class ScopeGuard {
        public:
-        ScopeGuard(
-            std::vector<std::unordered_map<std::string, VariableInfo>>& scopes_)
-            : scopes(scopes_) {
-            scopes.emplace_back();
+        ScopeGuard(Resolver& resolver_) : resolver(resolver_) {
+            resolver.m_scopes.emplace_back();
         }
         ~ScopeGuard();
 
        private:
-        std::vector<std::unordered_map<std::string, VariableInfo>>& scopes;
+        Resolver& resolver;
+    };
+
+    // A function being resolved; its scopes start at m_scopes[base]
+    struct FunctionScope {
+        FunctionExpr* function;
+        std::size_t   base;
     };
 
     void Declare(const Token& name);
     void Define(const Token& name);
 
     template <typename T>
-        requires requires(T t) { t.depth; }
+        requires requires(T t) {
+            t.depth;
+            t.upvalue;
+        }
     void ResolveLocal(T& expr, const Token& name) {
         for (int i = static_cast<int>(m_scopes.size()) - 1; i >= 0; --i) {
             auto it = m_scopes[i].find(name.GetLexeme());
             if (it != m_scopes[i].end()) {
                 it->second.used = true;
-                expr.depth      = static_cast<int>(m_scopes.size()) - 1 - i;
+                // Declared outside the innermost function: captured
+                if (!m_functions.empty() &&
+                    static_cast<std::size_t>(i) < m_functions.back().base)
+                    expr.upvalue =
+                        ResolveUpvalue(m_functions.size() - 1, i, name);
+                else
+                    expr.depth = static_cast<int>(m_scopes.size()) - 1 - i;
                 return;
             }
         }
     }
+    // Index of the upvalue through which function `level` reaches the
+    // variable `name` declared in m_scopes[scope], adding it to that function
+    // and the ones between if needed
+    int  ResolveUpvalue(std::size_t level, std::size_t scope,
+                        const Token& name);
     void ResolveFunction(FunctionExpr& expr, FunctionType type);
 
     void Resolve(Stmt& statement);
@@ -85,8 +112,10 @@ class Resolver {
 
    private:
     Interpreter& m_interpreter;
+    Diagnostics& m_diagnostics;
 
     std::vector<std::unordered_map<std::string, VariableInfo>> m_scopes{};
+    std::vector<FunctionScope>                                 m_functions{};
 
     FunctionType m_current_function_type{FunctionType::NONE};
     ClassType    m_current_class_type{ClassType::NONE};
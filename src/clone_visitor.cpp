@@ -96,6 +96,63 @@ struct ExprCloner {
             AssignExpr{e.name, e.value ? std::make_unique<Expr>(Clone(*e.value))
                                        : nullptr}};
     }
+    Expr operator()(const ArrayExpr& e) const {
+        std::vector<std::unique_ptr<Expr>> elements;
+        elements.reserve(e.elements.size());
+
+        for (const auto& element : e.elements) {
+            elements.push_back(
+                element ? std::make_unique<Expr>(Clone(*element)) : nullptr);
+        }
+
+        return Expr{ArrayExpr{e.bracket, std::move(elements)}};
+    }
+    Expr operator()(const MapExpr& e) const {
+        std::vector<std::unique_ptr<Expr>> keys;
+        std::vector<std::unique_ptr<Expr>> values;
+        keys.reserve(e.keys.size());
+        values.reserve(e.values.size());
+
+        for (const auto& key : e.keys)
+            keys.push_back(std::make_unique<Expr>(Clone(*key)));
+        for (const auto& value : e.values)
+            values.push_back(std::make_unique<Expr>(Clone(*value)));
+
+        return Expr{MapExpr{e.brace, std::move(keys), std::move(values)}};
+    }
+    Expr operator()(const IndexExpr& e) const {
+        return Expr{IndexExpr{std::make_unique<Expr>(Clone(*e.object)),
+                              e.bracket,
+                              std::make_unique<Expr>(Clone(*e.index))}};
+    }
+    Expr operator()(const IndexSetExpr& e) const {
+        return Expr{IndexSetExpr{std::make_unique<Expr>(Clone(*e.object)),
+                                 e.bracket,
+                                 std::make_unique<Expr>(Clone(*e.index)),
+                                 std::make_unique<Expr>(Clone(*e.value))}};
+    }
+    // Like the rest of the clone, fused nodes come back unresolved, so they
+    // are expanded into the nodes they replaced
+    Expr operator()(const IncrementExpr& e) const {
+        auto sum = std::make_unique<Expr>(BinaryExpr{
+            std::make_unique<Expr>(VariableExpr{e.name}), e.op,
+            std::make_unique<Expr>(LiteralExpr{PopLObject{e.constant}})});
+        return Expr{AssignExpr{e.name, std::move(sum)}};
+    }
+    Expr operator()(const CompareExpr& e) const {
+        auto right = e.right ? Expr{VariableExpr{e.right->name}}
+                             : Expr{LiteralExpr{PopLObject{e.constant}}};
+        return Expr{BinaryExpr{
+            std::make_unique<Expr>(VariableExpr{e.left.name}), e.op,
+            std::make_unique<Expr>(std::move(right))}};
+    }
+    Expr operator()(const ThisGetExpr& e) const {
+        return Expr{GetExpr{
+            std::make_unique<Expr>(ThisExpr{e.object.keyword}), e.name}};
+    }
+    Expr operator()(const InvariantExpr& e) const {
+        return Clone(*e.expression);
+    }
 };
 
 Expr Clone(const Expr& expr) { return visitExprWithArgs(expr, ExprCloner{}); }
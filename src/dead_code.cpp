@@ -0,0 +1,255 @@
+#include "popl/syntax/visitors/dead_code.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "popl/runtime/stats.hpp"
+#include "popl/syntax/ast/expr.hpp"
+#include "popl/syntax/ast/stmt.hpp"
+
+namespace popl {
+
+namespace {
+// Whether `expr` is a literal, and if so whether it is truthy
+std::optional<bool> ConstantCondition(const Expr& expr) {
+    auto* literal = std::get_if<LiteralExpr>(&expr.node);
+    if (!literal) return std::nullopt;
+    return literal->value.isTruthy();
+}
+
+// Whether running `stmt` never falls through to the statement after it. Blocks
+// are already cut after their first such statement, so only the last one of a
+// block needs checking.
+bool Terminates(const Stmt& stmt) {
+    if (std::holds_alternative<ReturnStmt>(stmt.node) ||
+        std::holds_alternative<BreakStmt>(stmt.node) ||
+        std::holds_alternative<ContinueStmt>(stmt.node))
+        return true;
+    if (auto* block = std::get_if<BlockStmt>(&stmt.node))
+        return !block->statements.empty() && block->statements.back() &&
+               Terminates(*block->statements.back());
+    if (auto* branch = std::get_if<IfStmt>(&stmt.node))
+        return Terminates(*branch->thenBranch) &&
+               Terminates(*branch->elseBranch);
+    return false;
+}
+
+// The name a top-level function or class declaration defines, if `stmt` is one
+const Token* DeclaredName(const Stmt& stmt) {
+    if (auto* function = std::get_if<FunctionStmt>(&stmt.node))
+        return &function->name;
+    if (auto* klass = std::get_if<ClassStmt>(&stmt.node)) return &klass->name;
+    return nullptr;
+}
+}  // namespace
+
+DeadCode::DeadCode(bool replMode) : m_repl_mode{replMode} {}
+
+void DeadCode::Optimize(std::vector<std::unique_ptr<Stmt>>& statements) {
+    // Globals referred to outside of the top-level declarations, which are
+    // what keeps declarations alive
+    Names live;
+    Uses  uses;
+    for (auto& stmt : statements) {
+        if (!stmt) continue;
+        m_references = !m_repl_mode && DeclaredName(*stmt) ? &uses[stmt.get()]
+                                                           : &live;
+        Optimize(*stmt);
+    }
+    m_references = nullptr;
+    // Top-level code cannot return, break or continue, so nothing in it is
+    // unreachable
+    if (!m_repl_mode) RemoveUnused(statements, std::move(live), uses);
+}
+void DeadCode::Optimize(Stmt& stmt) {
+    visitStmtWithArgs(
+        stmt,
+        [this](auto&& contained, Stmt& originalStmt) {
+            return (*this)(contained, originalStmt);
+        },
+        stmt);
+}
+void DeadCode::Optimize(Expr& expr) {
+    visitExprWithArgs(
+        expr,
+        [this](auto&& contained, Expr& originalExpr) {
+            return (*this)(contained, originalExpr);
+        },
+        expr);
+}
+
+void DeadCode::OptimizeBlock(std::vector<std::unique_ptr<Stmt>>& statements) {
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        if (!statements[i]) continue;
+        Optimize(*statements[i]);
+        if (Terminates(*statements[i])) {
+            POPL_STATS_ADD(statements_removed, statements.size() - i - 1);
+            statements.erase(statements.begin() + i + 1, statements.end());
+        }
+    }
+}
+
+void DeadCode::RemoveUnused(std::vector<std::unique_ptr<Stmt>>& statements,
+                            Names live, const Uses& uses) {
+    // A name may be declared more than once; all of its declarations stay
+    std::unordered_multimap<std::string, const Names*> declarations;
+    for (const auto& [stmt, used] : uses)
+        declarations.emplace(DeclaredName(*stmt)->GetLexeme(), &used);
+
+    std::vector<std::string> pending(live.begin(), live.end());
+    while (!pending.empty()) {
+        std::string name = std::move(pending.back());
+        pending.pop_back();
+        auto [first, last] = declarations.equal_range(name);
+        for (auto it = first; it != last; ++it)
+            for (const auto& used : *it->second)
+                if (live.insert(used).second) pending.push_back(used);
+    }
+
+    auto removed = std::erase_if(statements, [&](const auto& stmt) {
+        return stmt && uses.contains(stmt.get()) &&
+               !live.contains(DeclaredName(*stmt)->GetLexeme());
+    });
+    POPL_STATS_ADD(statements_removed, removed);
+}
+
+void DeadCode::Reference(const Token& name, const std::optional<int>& depth,
+                         const std::optional<int>& upvalue) {
+    if (!depth && !upvalue) m_references->insert(name.GetLexeme());
+}
+
+/*
+ * Statements
+ */
+void DeadCode::operator()(ExpressionStmt& stmt, Stmt&) {
+    Optimize(*stmt.expression);
+}
+void DeadCode::operator()(NilStmt&, Stmt&) {}
+void DeadCode::operator()(VarStmt& stmt, Stmt&) {
+    if (stmt.initializer) Optimize(*stmt.initializer);
+}
+void DeadCode::operator()(BlockStmt& stmt, Stmt&) {
+    OptimizeBlock(stmt.statements);
+}
+void DeadCode::operator()(IfStmt& stmt, Stmt& originalStmt) {
+    auto constant = ConstantCondition(*stmt.condition);
+    if (!constant) {
+        Optimize(*stmt.condition);
+        Optimize(*stmt.thenBranch);
+        Optimize(*stmt.elseBranch);
+        return;
+    }
+    // An if creates no scope, so the taken branch can stand in for it
+    Stmt taken = std::move(*constant ? *stmt.thenBranch : *stmt.elseBranch);
+    Optimize(taken);
+    POPL_STATS_INC(statements_removed);
+    originalStmt = std::move(taken);
+}
+void DeadCode::operator()(WhileStmt& stmt, Stmt& originalStmt) {
+    if (ConstantCondition(*stmt.condition) == false) {
+        POPL_STATS_INC(statements_removed);
+        originalStmt = Stmt{NilStmt{}};
+        return;
+    }
+    Optimize(*stmt.condition);
+    Optimize(*stmt.body);
+}
+void DeadCode::operator()(BreakStmt&, Stmt&) {}
+void DeadCode::operator()(ContinueStmt&, Stmt&) {}
+void DeadCode::operator()(ReturnStmt& stmt, Stmt&) {
+    if (stmt.value) Optimize(*stmt.value);
+}
+void DeadCode::operator()(FunctionStmt& stmt, Stmt&) {
+    OptimizeBlock(stmt.func->body);
+}
+void DeadCode::operator()(ClassStmt& stmt, Stmt&) {
+    for (auto& method : stmt.methods) OptimizeBlock(method->func->body);
+}
+
+/*
+ * Expressions
+ */
+void DeadCode::operator()(LiteralExpr&, Expr&) {}
+void DeadCode::operator()(GroupingExpr& expr, Expr&) {
+    Optimize(*expr.expression);
+}
+void DeadCode::operator()(TernaryExpr& expr, Expr& originalExpr) {
+    auto constant = ConstantCondition(*expr.condition);
+    if (!constant) {
+        Optimize(*expr.condition);
+        Optimize(*expr.thenBranch);
+        Optimize(*expr.elseBranch);
+        return;
+    }
+    Expr taken = std::move(*constant ? *expr.thenBranch : *expr.elseBranch);
+    Optimize(taken);
+    originalExpr = std::move(taken);
+}
+void DeadCode::operator()(UnaryExpr& expr, Expr&) { Optimize(*expr.right); }
+void DeadCode::operator()(BinaryExpr& expr, Expr&) {
+    Optimize(*expr.left);
+    Optimize(*expr.right);
+}
+void DeadCode::operator()(VariableExpr& expr, Expr&) {
+    Reference(expr.name, expr.depth, expr.upvalue);
+}
+void DeadCode::operator()(NilExpr&, Expr&) {}
+void DeadCode::operator()(LogicalExpr& expr, Expr&) {
+    Optimize(*expr.left);
+    Optimize(*expr.right);
+}
+void DeadCode::operator()(CallExpr& expr, Expr&) {
+    Optimize(*expr.callee);
+    for (auto& arg : expr.arguments) Optimize(*arg);
+}
+void DeadCode::operator()(AssignExpr& expr, Expr&) {
+    // Assigning a removed declaration's name would fail, so it counts too
+    Reference(expr.name, expr.depth, expr.upvalue);
+    Optimize(*expr.value);
+}
+void DeadCode::operator()(FunctionExpr& expr, Expr&) {
+    OptimizeBlock(expr.body);
+}
+void DeadCode::operator()(GetExpr& expr, Expr&) { Optimize(*expr.object); }
+void DeadCode::operator()(SetExpr& expr, Expr&) {
+    Optimize(*expr.object);
+    Optimize(*expr.value);
+}
+void DeadCode::operator()(ThisExpr&, Expr&) {}
+void DeadCode::operator()(ArrayExpr& expr, Expr&) {
+    for (auto& element : expr.elements) Optimize(*element);
+}
+void DeadCode::operator()(IndexExpr& expr, Expr&) {
+    Optimize(*expr.object);
+    Optimize(*expr.index);
+}
+void DeadCode::operator()(IndexSetExpr& expr, Expr&) {
+    Optimize(*expr.object);
+    Optimize(*expr.index);
+    Optimize(*expr.value);
+}
+void DeadCode::operator()(MapExpr& expr, Expr&) {
+    for (std::size_t i = 0; i < expr.keys.size(); ++i) {
+        Optimize(*expr.keys[i]);
+        Optimize(*expr.values[i]);
+    }
+}
+// The later passes' nodes, for trees that went through them already
+void DeadCode::operator()(IncrementExpr& expr, Expr&) {
+    Reference(expr.name, expr.depth, expr.upvalue);
+}
+void DeadCode::operator()(CompareExpr& expr, Expr&) {
+    Reference(expr.left.name, expr.left.depth, expr.left.upvalue);
+    if (expr.right)
+        Reference(expr.right->name, expr.right->depth, expr.right->upvalue);
+}
+void DeadCode::operator()(ThisGetExpr&, Expr&) {}
+void DeadCode::operator()(InvariantExpr& expr, Expr&) {
+    Optimize(*expr.expression);
+}
+
+}  // namespace popl
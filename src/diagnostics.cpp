@@ -8,9 +8,6 @@
 
 namespace popl {
 
-bool Diagnostics::ms_had_error         = false;
-bool Diagnostics::ms_had_runtime_error = false;
-
 void Diagnostics::Error(unsigned int line, std::string_view message) {
     Report(line, "", message);
 }
@@ -23,15 +20,15 @@ void Diagnostics::Error(Token token, std::string_view message) {
 }
 
 void Diagnostics::ReportRunTimeError(const runtime::RunTimeError& error) {
-    std::println("[RunTimeError] : {} at {} at [line {}]", error.what(),
+    std::println(m_out, "[RunTimeError] : {} at {} at [line {}]", error.what(),
                  error.GetToken().GetLexeme(), error.GetToken().GetLine());
-    ms_had_runtime_error = true;
+    m_had_runtime_error = true;
 }
 
 void Diagnostics::Report(unsigned int line, std::string_view where,
                          std::string_view message) {
-    ms_had_error = true;
-    std::println(stderr, "[line {}] Error {} : {}", line, where, message);
+    m_had_error = true;
+    std::println(m_err, "[line {}] Error {} : {}", line, where, message);
 }
 
 };  // namespace popl
@@ -1,5 +1,7 @@
 #include "popl/driver.hpp"
 
+#include <charconv>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <print>
@@ -9,30 +11,147 @@
 #include "popl/diagnostics.hpp"
 #include "popl/lexer/lexer.hpp"
 #include "popl/lexer/token_types.hpp"
+#include "popl/runtime/stats.hpp"
 #include "popl/syntax/grammar/parser.hpp"
+#include "popl/syntax/visitors/dead_code.hpp"
+#include "popl/syntax/visitors/loop_invariants.hpp"
+#include "popl/syntax/visitors/peephole.hpp"
 #include "popl/syntax/visitors/resolver.hpp"
 #include "popl/utils.hpp"
 
 namespace popl {
-Interpreter Driver::interpreter{};
-int         Driver::Init(int argc, char** argv) {
-    if (argc > 2) {
+
+template <typename T>
+static bool ParseNumber(std::string_view text, T& out) {
+    const char* last   = text.data() + text.size();
+    auto [end, error] = std::from_chars(text.data(), last, out);
+    return error == std::errc{} && end == last;
+}
+
+int Driver::Init(int argc, char** argv) {
+    std::vector<std::string_view> scripts;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg.starts_with("--")) {
+            if (!ParseOption(arg)) {
+                PrintUsage();
+                return 64;
+            }
+        } else {
+            scripts.push_back(arg);
+        }
+    }
+    if (scripts.size() > 1) {
         PrintUsage();
         return 64;
-    } else if (argc == 2) {
-        return RunFile(argv[1]);
-    } else {
-        return RunRepl();
     }
+
+    SetLimits(m_limits);
+    if (!m_trace_path.empty()) {
+        m_tracer = std::make_unique<runtime::Tracer>();
+        m_interpreter.SetTracer(m_tracer.get());
+    }
+
+    if (scripts.size() == 1) return RunFile(scripts.front());
+    int status = RunRepl();
+    Finish();
+    return status;
 }
 
-void Driver::PrintUsage() const { std::print("Usage: popl [script]"); }
+bool Driver::ParseOption(std::string_view option) {
+    constexpr std::string_view trace_prefix{"--trace="};
+    if (option.starts_with(trace_prefix) &&
+        option.size() > trace_prefix.size()) {
+        m_trace_path = option.substr(trace_prefix.size());
+        return true;
+    }
+    if (option == "--stats") {
+        m_print_stats = true;
+        return true;
+    }
+    if (option == "--allow-exec") {
+        m_limits.allow_exec = true;
+        return true;
+    }
+    if (option == "--allow-files") {
+        m_limits.allow_files = true;
+        return true;
+    }
+    if (option == "--output=line" || option == "--output=full") {
+        m_interpreter.GetOutput().SetMode(
+            option.ends_with("line") ? runtime::OutputBuffer::Mode::LINE
+                                     : runtime::OutputBuffer::Mode::FULL);
+        return true;
+    }
+
+    auto value_of = [&](std::string_view prefix) {
+        return option.substr(prefix.size());
+    };
+    if (option.starts_with("--max-statements="))
+        return ParseNumber(value_of("--max-statements="),
+                           m_limits.max_statements);
+    if (option.starts_with("--max-alloc-bytes="))
+        return ParseNumber(value_of("--max-alloc-bytes="),
+                           m_limits.max_alloc_bytes);
+    if (option.starts_with("--max-call-depth="))
+        return ParseNumber(value_of("--max-call-depth="),
+                           m_limits.max_call_depth);
+    if (option.starts_with("--max-time-ms=")) {
+        std::int64_t ms = 0;
+        if (!ParseNumber(value_of("--max-time-ms="), ms)) return false;
+        m_limits.max_wall_time = std::chrono::milliseconds{ms};
+        return true;
+    }
+    return false;
+}
+
+void Driver::SetLimits(const runtime::ResourceLimits& limits) {
+    m_limits = limits;
+    m_interpreter.SetLimits(limits);
+}
+
+void Driver::PrintUsage() const {
+    std::print(
+        "Usage: popl [--trace=<out.json>] [--stats] [--output=line|full]\n"
+        "            [--max-statements=N] [--max-time-ms=N] "
+        "[--max-alloc-bytes=N]\n"
+        "            [--max-call-depth=N] [--allow-exec] [--allow-files]\n"
+        "            [script]\n"
+        "File natives (openFile, readFile, readFileAsync) are off by default;\n"
+        "--allow-files enables them. --allow-exec enables execAsync.");
+}
+
+void Driver::Finish() const {
+    WriteTrace();
+    PrintStats();
+}
+
+void Driver::WriteTrace() const {
+    if (!m_tracer) return;
+    try {
+        m_tracer->Write(m_trace_path);
+    } catch (const std::runtime_error& e) {
+        std::print("Error: {}\n", e.what());
+    }
+}
+
+void Driver::PrintStats() const {
+    if (!m_print_stats) return;
+    if constexpr (runtime::StatsEnabled()) {
+        runtime::GetStats().Print(stderr);
+    } else {
+        std::println(stderr,
+                     "popl: statistics are not compiled in, reconfigure with "
+                     "-DPOPL_ENABLE_STATS=ON");
+    }
+}
 
 int Driver::RunFile(std::string_view path) {
     try {
         Run(utils::ReadFile(path));
-        if (Diagnostics::HadError()) std::exit(65);
-        if (Diagnostics::HadRunTimeError()) std::exit(70);
+        Finish();
+        if (GetDiagnostics().HadError()) std::exit(65);
+        if (GetDiagnostics().HadRunTimeError()) std::exit(70);
     } catch (const std::runtime_error& e) {
         std::print("Error: {}\n", e.what());
     }
@@ -52,12 +171,17 @@ int Driver::RunRepl() {
 
         buffer += line + "\n";
 
-        Lexer lexer{buffer};
-        buffer_tokens = lexer.ScanTokens();
+        Lexer lexer{buffer, GetDiagnostics()};
+        {
+            runtime::TraceScope trace{m_tracer.get(), "Lexer::ScanTokens",
+                                      runtime::TraceCategory::PHASE};
+            POPL_STATS_TIMER(lex_time);
+            buffer_tokens = lexer.ScanTokens();
+        }
 
         if (IsStatementComplete(buffer_tokens)) {
             Run(buffer_tokens, true);
-            Diagnostics::ResetError();
+            GetDiagnostics().ResetError();
             buffer.clear();
             buffer_tokens.clear();
         } else {
@@ -68,23 +192,53 @@ int Driver::RunRepl() {
 }
 
 void Driver::Run(std::string source, bool replMode) {
-    Lexer lexer{std::move(source)};
-    auto  tokens{lexer.ScanTokens()};
+    Lexer              lexer{std::move(source), GetDiagnostics()};
+    std::vector<Token> tokens;
+    {
+        runtime::TraceScope trace{m_tracer.get(), "Lexer::ScanTokens",
+                                  runtime::TraceCategory::PHASE};
+        POPL_STATS_TIMER(lex_time);
+        tokens = lexer.ScanTokens();
+    }
     Run(tokens, replMode);
 }
 
 void Driver::Run(const std::vector<Token>& tokens, bool replMode) {
-    Parser parser{tokens};
-    auto   statements = parser.Parse();
+    using runtime::TraceCategory;
+    using runtime::TraceScope;
 
-    if (Diagnostics::HadError()) return;
+    Parser                             parser{tokens, GetDiagnostics()};
+    std::vector<std::unique_ptr<Stmt>> statements;
+    {
+        TraceScope trace{m_tracer.get(), "Parser::Parse", TraceCategory::PHASE};
+        POPL_STATS_TIMER(parse_time);
+        statements = parser.Parse();
+    }
+
+    if (GetDiagnostics().HadError()) return;
 
-    Resolver resolver{interpreter};
-    resolver.Resolve(statements);
+    Resolver resolver{m_interpreter};
+    {
+        TraceScope trace{m_tracer.get(), "Resolver::Resolve",
+                         TraceCategory::PHASE};
+        POPL_STATS_TIMER(resolve_time);
+        resolver.Resolve(statements);
+    }
 
-    if (Diagnostics::HadError()) return;
+    if (GetDiagnostics().HadError()) return;
+
+    {
+        TraceScope trace{m_tracer.get(), "Optimize", TraceCategory::PHASE};
+        POPL_STATS_TIMER(optimize_time);
+        DeadCode{replMode}.Optimize(statements);
+        LoopInvariants{m_interpreter}.Optimize(statements);
+        Peephole{}.Optimize(statements);
+    }
 
-    interpreter.Interpret(statements, replMode);
+    TraceScope trace{m_tracer.get(), "Interpreter::Interpret",
+                     TraceCategory::PHASE};
+    POPL_STATS_TIMER(interpret_time);
+    m_interpreter.Interpret(statements, replMode);
 }
 
 bool Driver::IsStatementComplete(const std::vector<Token>& tokens) const {
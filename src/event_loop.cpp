@@ -0,0 +1,137 @@
+#include "popl/runtime/event_loop.hpp"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace popl::runtime {
+
+static std::runtime_error SystemError(std::string_view what) {
+    return std::runtime_error(std::string{what} + ": " + std::strerror(errno));
+}
+
+void AsyncTask::promise_type::unhandled_exception() {
+    loop.Fail(std::current_exception());
+}
+
+EventLoop::EventLoop() : m_epoll{epoll_create1(EPOLL_CLOEXEC)} {
+    if (m_epoll < 0) throw SystemError("epoll_create1");
+}
+
+EventLoop::~EventLoop() {
+    Clear();
+    close(m_epoll);
+}
+
+// Milliseconds to wait in epoll_wait() before `deadline`, rounded up so the
+// wait does not end just short of it; -1 waits without a timeout
+static int WaitTimeout(
+    std::optional<std::chrono::steady_clock::time_point> deadline) {
+    if (!deadline) return -1;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(
+        *deadline - std::chrono::steady_clock::now());
+    return static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(
+        left.count(), 0, std::numeric_limits<int>::max()));
+}
+
+bool EventLoop::Run(
+    std::optional<std::chrono::steady_clock::time_point> deadline) {
+    while (!m_ready.empty() || !m_waiting.empty()) {
+        // Waits only when nothing is ready; otherwise just picks up what
+        // became ready, so a task that keeps yielding cannot starve the rest
+        if (!m_waiting.empty()) {
+            bool idle = m_ready.empty();
+            if (idle && deadline &&
+                std::chrono::steady_clock::now() >= *deadline)
+                return false;
+            Poll(idle ? WaitTimeout(deadline) : 0);
+        }
+        // One round: tasks queued while it runs go after the next poll
+        for (auto count = m_ready.size(); count > 0; --count) {
+            auto handle = m_ready.front();
+            m_ready.pop_front();
+            handle.resume();
+            if (m_error) {
+                Clear();
+                std::rethrow_exception(std::exchange(m_error, nullptr));
+            }
+        }
+    }
+    return true;
+}
+
+void EventLoop::Poll(int timeout_ms) {
+    epoll_event events[16];
+    int         count = epoll_wait(m_epoll, events, 16, timeout_ms);
+    if (count < 0 && errno != EINTR) throw SystemError("epoll_wait");
+    for (int i = 0; i < count; ++i) {
+        int fd = events[i].data.fd;
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        m_ready.push_back(m_waiting.extract(fd).mapped());
+    }
+}
+
+void EventLoop::Clear() {
+    for (auto& [fd, handle] : m_waiting) {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        handle.destroy();
+    }
+    m_waiting.clear();
+    for (auto handle : m_ready) handle.destroy();
+    m_ready.clear();
+}
+
+void EventLoop::Fail(std::exception_ptr error) {
+    if (!m_error) m_error = std::move(error);
+}
+
+void EventLoop::Awaiter::await_suspend(std::coroutine_handle<> handle) {
+    if (m_fd < 0)
+        m_loop.m_ready.push_back(handle);
+    else
+        m_loop.Watch(m_fd, handle);
+}
+
+EventLoop::Awaiter EventLoop::Sleep(std::chrono::milliseconds delay) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) throw SystemError("timerfd_create");
+    auto       ns = std::chrono::nanoseconds{delay}.count();
+    itimerspec spec{};
+    spec.it_value.tv_sec  = ns / 1'000'000'000;
+    spec.it_value.tv_nsec = ns % 1'000'000'000;
+    if (ns <= 0) spec.it_value.tv_nsec = 1;  // an all-zero value disarms
+    timerfd_settime(fd, 0, &spec, nullptr);
+    return Awaiter{*this, fd};
+}
+
+EventLoop::Awaiter EventLoop::Readable(int fd) {
+    // The waiting set is keyed by fd, so every wait gets its own descriptor
+    int copy = dup(fd);
+    if (copy < 0) throw SystemError("dup");
+    return Awaiter{*this, copy};
+}
+
+void EventLoop::Watch(int fd, std::coroutine_handle<> handle) {
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) == 0) {
+        m_waiting.emplace(fd, handle);
+        return;
+    }
+    // epoll refuses regular files (EPERM); they never block, so go ahead
+    close(fd);
+    m_ready.push_back(handle);
+}
+
+}  // namespace popl::runtime
@@ -0,0 +1,167 @@
+#include "popl/runtime/file_table.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace popl::runtime {
+
+std::unique_ptr<File> File::Open(const std::string& path, Mode mode) {
+    int flags = O_CLOEXEC;
+    switch (mode) {
+        case Mode::READ:
+            flags |= O_RDONLY;
+            break;
+        case Mode::WRITE:
+            flags |= O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+        case Mode::APPEND:
+            flags |= O_WRONLY | O_CREAT | O_APPEND;
+            break;
+    }
+    int fd = ::open(path.c_str(), flags, 0666);
+    if (fd < 0) return nullptr;
+    return std::unique_ptr<File>(new File(fd, mode));
+}
+
+File::File(int fd, Mode mode) : m_fd{fd}, m_mode{mode} {
+    if (IsReadable()) {
+        m_buffer = std::make_unique_for_overwrite<char[]>(kBufferSize);
+        posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } else {
+        m_output =
+            std::make_unique<OutputBuffer>(m_fd, OutputBuffer::Mode::FULL);
+    }
+}
+
+File::~File() {
+    m_output.reset();  // flushes
+    ::close(m_fd);
+}
+
+ssize_t File::Fill() {
+    m_begin = m_end = 0;
+    ssize_t count;
+    do {
+        count = ::read(m_fd, m_buffer.get(), kBufferSize);
+    } while (count < 0 && errno == EINTR);
+    if (count > 0) m_end = static_cast<std::size_t>(count);
+    return count;
+}
+
+std::optional<std::string> File::ReadLine() {
+    // A line that crosses a refill is gathered here; one inside the buffer
+    // is copied out in a single allocation
+    std::string partial;
+    bool        any = false;
+    for (;;) {
+        if (m_begin == m_end && Fill() <= 0) break;
+        any               = true;
+        const char* begin = m_buffer.get() + m_begin;
+        std::size_t size  = m_end - m_begin;
+        const void* found = std::memchr(begin, '\n', size);
+        if (found) {
+            std::size_t length = static_cast<const char*>(found) - begin;
+            m_begin += length + 1;
+            if (partial.empty()) return std::string(begin, length);
+            partial.append(begin, length);
+            return partial;
+        }
+        partial.append(begin, size);
+        m_begin = m_end;
+    }
+    if (!any) return std::nullopt;
+    return partial;
+}
+
+std::optional<std::string> File::ReadChunk(std::size_t max) {
+    std::string chunk;
+    if (m_begin == m_end) {
+        // Large requests bypass the buffer, a bounded piece at a time
+        if (max >= kBufferSize) {
+            max = std::min(max, kMaxDirectRead);
+            ssize_t count;
+            chunk.resize_and_overwrite(max, [&](char* data, std::size_t) {
+                do {
+                    count = ::read(m_fd, data, max);
+                } while (count < 0 && errno == EINTR);
+                return static_cast<std::size_t>(std::max<ssize_t>(count, 0));
+            });
+            if (count < 0) return std::nullopt;
+            return chunk;
+        }
+        ssize_t count = Fill();
+        if (count < 0) return std::nullopt;
+        if (count == 0) return chunk;
+    }
+    std::size_t size = std::min(max, m_end - m_begin);
+    chunk.assign(m_buffer.get() + m_begin, size);
+    m_begin += size;
+    return chunk;
+}
+
+void File::Write(std::string_view text) { m_output->Write(text); }
+
+void File::Flush() {
+    if (m_output) m_output->Flush();
+}
+
+FileTable::Id FileTable::Add(std::unique_ptr<File> file) {
+    Id id = m_next_id++;
+    m_files.emplace(id, std::move(file));
+    return id;
+}
+
+File* FileTable::Get(Id id) const {
+    auto it = m_files.find(id);
+    return it == m_files.end() ? nullptr : it->second.get();
+}
+
+bool FileTable::Close(Id id) { return m_files.erase(id) > 0; }
+
+void FileTable::FlushAll() {
+    for (auto& [id, file] : m_files) file->Flush();
+}
+
+// Fallback for pipes and files whose size stat() does not know
+static bool ReadAll(int fd, std::string& contents) {
+    char buffer[File::kBufferSize];
+    for (;;) {
+        ssize_t count = ::read(fd, buffer, sizeof buffer);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) return false;
+        if (count == 0) return true;
+        contents.append(buffer, static_cast<std::size_t>(count));
+    }
+}
+
+std::optional<std::string> ReadWholeFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+    std::optional<std::string> contents{std::in_place};
+
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        auto  size = static_cast<std::size_t>(info.st_size);
+        void* map  = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            ::madvise(map, size, MADV_SEQUENTIAL);
+            contents->assign(static_cast<const char*>(map), size);
+            ::munmap(map, size);
+            ::close(fd);
+            return contents;
+        }
+    }
+    if (!ReadAll(fd, *contents)) contents.reset();
+    int saved = errno;
+    ::close(fd);
+    errno = saved;
+    return contents;
+}
+
+}  // namespace popl::runtime
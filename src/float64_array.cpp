@@ -0,0 +1,15 @@
+#include "popl/runtime/float64_array.hpp"
+
+#include "popl/literal.hpp"
+
+namespace popl::runtime {
+
+std::string Float64Array::ToString() const {
+    std::string out{"Float64Array["};
+    for (std::size_t i = 0; i < m_data.size(); ++i) {
+        if (i) out += ", ";
+        out += PopLObject(m_data[i]).toString();
+    }
+    return out + "]";
+}
+};  // namespace popl::runtime
@@ -1,8 +1,10 @@
 #include "popl/syntax/visitors/interpreter.hpp"
 
+#include <cmath>
 #include <format>
 #include <memory>
-#include <print>
+#include <memory_resource>
+#include <utility>
 
 #include "popl/callables/callable.hpp"
 #include "popl/callables/popl_function.hpp"
@@ -10,16 +12,53 @@
 #include "popl/lexer/token_types.hpp"
 #include "popl/literal.hpp"
 #include "popl/runtime/control_flow.hpp"
+#include "popl/runtime/popl_array.hpp"
 #include "popl/runtime/popl_class.hpp"
+#include "popl/runtime/popl_map.hpp"
 #include "popl/runtime/run_time_error.hpp"
+#include "popl/runtime/stats.hpp"
+#include "popl/runtime/workers.hpp"
 #include "popl/syntax/ast/expr.hpp"
 #include "popl/syntax/ast/stmt.hpp"
 
 namespace popl {
 
+namespace {
+class CallDepthGuard {
+   public:
+    explicit CallDepthGuard(std::uint32_t& depth) : m_depth{depth} {
+        ++m_depth;
+    }
+    ~CallDepthGuard() { --m_depth; }
+
+   private:
+    std::uint32_t& m_depth;
+};
+
+// Also hands what the meter counted to the shared budget on the way out, so
+// a worker's last statements are not lost when it returns
+class CurrentMeterScope {
+   public:
+    explicit CurrentMeterScope(runtime::ResourceMeter* meter)
+        : m_previous{runtime::t_current_meter} {
+        runtime::t_current_meter = meter;
+    }
+    ~CurrentMeterScope() {
+        runtime::t_current_meter->Flush();
+        runtime::t_current_meter = m_previous;
+    }
+
+   private:
+    runtime::ResourceMeter* m_previous;
+};
+}  // namespace
+
 void Interpreter::Interpret(std::vector<std::unique_ptr<Stmt>>& statements,
                             bool                                replMode) {
     m_repl_mode = replMode;
+    m_meter.Start();
+    CurrentMeterScope         meter_scope{&m_meter};
+    runtime::CurrentPoolScope pool_scope{m_pool.get()};
     try {
         for (auto& statement : statements) {
             if (replMode) {
@@ -31,9 +70,55 @@ void Interpreter::Interpret(std::vector<std::unique_ptr<Stmt>>& statements,
                 Execute(*statement);
             }
         }
+        RunEventLoop();
     } catch (const runtime::RunTimeError& error) {
-        Diagnostics::ReportRunTimeError(error);
+        if (m_event_loop) m_event_loop->Clear();
+        m_output.Flush();
+        m_diagnostics.ReportRunTimeError(error);
+    }
+    m_output.Flush();
+    m_files.FlushAll();
+    // Workers run code from `statements`, which the caller frees after this
+    if (!replMode && m_owns_worker_group) m_worker_group->Shutdown();
+}
+Interpreter::~Interpreter() {
+    if (m_owns_worker_group) m_worker_group->Shutdown();
+}
+PopLObject Interpreter::CallFunction(const PopLObject&           callee,
+                                     std::span<const PopLObject> args) {
+    CurrentMeterScope         meter_scope{&m_meter};
+    runtime::CurrentPoolScope pool_scope{m_pool.get()};
+    PopLObject                result{NilValue{}};
+    {
+        CallDepthGuard depth_guard{m_call_depth};
+        POPL_STATS_CALL_SCOPE();
+        result = callee.asCallable()->Call(*this, args);
+    }
+    RunEventLoop();
+    return result;
+}
+PopLObject Interpreter::CallBack(std::string_view               native,
+                                 const PopLObject::CallablePtr& callee,
+                                 std::span<const PopLObject>    args) {
+    return Call(Token{TokenType::IDENTIFIER, std::string{native},
+                      PopLObject{NilValue{}}, 0},
+                callee, args);
+}
+runtime::WorkerGroup& Interpreter::GetWorkerGroup() {
+    if (!m_worker_group) {
+        m_worker_group      = std::make_shared<runtime::WorkerGroup>();
+        m_owns_worker_group = true;
     }
+    return *m_worker_group;
+}
+runtime::EventLoop& Interpreter::GetEventLoop() {
+    if (!m_event_loop) m_event_loop = std::make_unique<runtime::EventLoop>();
+    return *m_event_loop;
+}
+void Interpreter::JoinWorkerGroup(
+    std::shared_ptr<runtime::WorkerGroup> group) {
+    m_worker_group      = std::move(group);
+    m_owns_worker_group = false;
 }
 void Interpreter::Resolve(const Expr& expr, int depth) {
     m_locals[&expr] = depth;
@@ -43,7 +128,7 @@ void Interpreter::operator()(const ExpressionStmt& stmt, const Stmt&) {
     PopLObject obj = Evaluate(*(stmt.expression));
     if (m_repl_mode) {
         CheckUninitialised(MakeReplReadToken(), obj);
-        if (!obj.isNil()) std::println("{}", obj.toString());
+        if (!obj.isNil()) m_output.WriteLine(obj.toString());
     }
 }
 void Interpreter::operator()(const NilStmt& stmt, const Stmt&) {
@@ -52,11 +137,14 @@ void Interpreter::operator()(const NilStmt& stmt, const Stmt&) {
 void Interpreter::operator()(const VarStmt& stmt, const Stmt&) {
     PopLObject value{UninitializedValue{}};
     if (stmt.initializer) value = Evaluate(*(stmt.initializer));
-    m_current_environment->Define(stmt.name, value);
+    m_current_environment->Define(stmt.name, std::move(value));
 }
 void Interpreter::operator()(const BlockStmt& stmt, const Stmt&) {
-    auto blockEnv = std::make_shared<Environment>(m_current_environment);
-    ExecuteBlock(stmt.statements, blockEnv);
+    // Closures capture cells, never the environment, so it can live on the
+    // stack
+    POPL_STATS_INC(stack_environments);
+    runtime::ScopedRef<Environment> frame{m_current_environment};
+    ExecuteBlock(stmt.statements, frame.Get());
 }
 
 void Interpreter::operator()(IfStmt& stmt, const Stmt&) {
@@ -77,6 +165,15 @@ void Interpreter::operator()(const ReturnStmt& stmt, const Stmt&) {
 }
 
 void Interpreter::operator()(WhileStmt& stmt, const Stmt&) {
+    // Values of the loop's invariant expressions, for this run of it only
+    std::pmr::vector<InvariantSlot> invariants(stmt.invariants,
+                                               runtime::CurrentResource());
+    struct Restore {
+        std::span<InvariantSlot>& invariants;
+        std::span<InvariantSlot>  previous;
+        ~Restore() { invariants = previous; }
+    } restore{m_invariants, std::exchange(m_invariants, invariants)};
+
     while (Evaluate(*stmt.condition).isTruthy()) {
         try {
             Execute(*stmt.body);
@@ -88,24 +185,24 @@ void Interpreter::operator()(WhileStmt& stmt, const Stmt&) {
     }
 }
 void Interpreter::operator()(FunctionStmt& stmt, const Stmt&) {
-    Token name = stmt.name;
-    auto  func = std::make_shared<callable::PoplFunction>(
-        stmt.func.get(), m_current_environment, stmt.name.GetLexeme(), false);
-    m_current_environment->Define(name, PopLObject{func});
+    auto func = runtime::MakeRef<callable::PoplFunction>(
+        stmt.func.get(), m_global_environment, stmt.name.GetLexeme(), false,
+        CaptureUpvalues(*stmt.func));
+    m_current_environment->Define(stmt.name, PopLObject{std::move(func)});
 }
 void Interpreter::operator()(ClassStmt& stmt, const Stmt&) {
     m_current_environment->Define(stmt.name, PopLObject(NilValue{}));
-    std::unordered_map<std::string, std::shared_ptr<callable::PoplFunction>>
+    std::unordered_map<std::string, runtime::Ref<callable::PoplFunction>>
         methods;
     for (auto& method : stmt.methods) {
-        auto func = std::make_shared<callable::PoplFunction>(
-            method->func.get(), m_current_environment, method->name.GetLexeme(),
-            method->name.GetLexeme() == "init");
+        auto func = runtime::MakeRef<callable::PoplFunction>(
+            method->func.get(), m_global_environment, method->name.GetLexeme(),
+            method->name.GetLexeme() == "init", CaptureUpvalues(*method->func));
         methods.insert_or_assign(method->name.GetLexeme(), std::move(func));
     }
-    auto klass = std::make_shared<runtime::PoplClass>(stmt.name.GetLexeme(),
+    auto klass = runtime::MakeRef<runtime::PoplClass>(stmt.name.GetLexeme(),
                                                       std::move(methods));
-    m_current_environment->Assign(stmt.name, PopLObject{klass});
+    m_current_environment->Assign(stmt.name, PopLObject{std::move(klass)});
 }
 
 /*
@@ -116,17 +213,13 @@ PopLObject Interpreter::operator()(const LiteralExpr& expr, const Expr&) const {
 }
 
 PopLObject Interpreter::operator()(const ThisExpr& expr, const Expr&) const {
-    if (expr.depth.has_value())
-        return m_current_environment->GetAt(expr.depth.value(), expr.keyword);
-    return m_global_environment->Get(expr.keyword);
+    return Variable(expr.keyword, expr.depth, expr.upvalue);
 }
 PopLObject Interpreter::operator()(const AssignExpr& expr, const Expr&) {
-    PopLObject value = Evaluate(*expr.value);
-
-    if (expr.depth.has_value())
-        m_current_environment->AssignAt(expr.depth.value(), expr.name, value);
-    m_global_environment->Assign(expr.name, value);
-    return value;
+    PopLObject  value = Evaluate(*expr.value);
+    PopLObject& slot  = Variable(expr.name, expr.depth, expr.upvalue);
+    slot              = std::move(value);
+    return slot;
 }
 
 PopLObject Interpreter::operator()(const GroupingExpr& expr, const Expr&) {
@@ -141,9 +234,15 @@ PopLObject Interpreter::operator()(const TernaryExpr& expr, const Expr&) {
 }
 PopLObject Interpreter::operator()(const VariableExpr& expr,
                                    const Expr&         originalExpr) const {
-    if (expr.depth.has_value())
-        return m_current_environment->GetAt(expr.depth.value(), expr.name);
-    return m_global_environment->Get(expr.name);
+    return Variable(expr.name, expr.depth, expr.upvalue);
+}
+PopLObject& Interpreter::Variable(const Token&              name,
+                                  const std::optional<int>& depth,
+                                  const std::optional<int>& upvalue) const {
+    if (upvalue.has_value()) return m_upvalues[*upvalue]->value;
+    if (depth.has_value())
+        return m_current_environment->GetMutableAt(*depth, name);
+    return m_global_environment->GetMutable(name);
 }
 PopLObject Interpreter::operator()(const NilExpr& expr, const Expr&) const {
     return PopLObject{NilValue{}};
@@ -159,25 +258,40 @@ PopLObject Interpreter::operator()(const LogicalExpr& expr, const Expr&) {
 }
 
 PopLObject Interpreter::operator()(const CallExpr& expr, const Expr&) {
-    PopLObject              callee{Evaluate(*expr.callee)};
-    std::vector<PopLObject> args;
-    for (const auto& expr : expr.arguments) args.emplace_back(Evaluate(*expr));
+    PopLObject                 callee{Evaluate(*expr.callee)};
+    runtime::ValueStack::Frame frame{m_value_stack, expr.arguments.size()};
+    for (const auto& expr : expr.arguments) frame.Push(Evaluate(*expr));
+    auto args = frame.Args();
     if (!callee.isCallable())
         throw runtime::RunTimeError(expr.ClosingParen,
                                     "Can only call function and classes.");
-    PopLObject::CallablePtr func{callee.asCallable()};
+    const PopLObject::CallablePtr& func{callee.asCallable()};
     if (func->GetArity() != args.size())
         throw runtime::RunTimeError(
             expr.ClosingParen, std::format("Expected {} arguments but got {}.",
                                            func->GetArity(), args.size()));
-    return func->Call(*this, args);
+    return Call(expr.ClosingParen, func, args);
+}
+PopLObject Interpreter::Call(const Token&                   where,
+                             const PopLObject::CallablePtr& callee,
+                             std::span<const PopLObject>    args) {
+    std::uint32_t max_depth = m_meter.GetLimits().max_call_depth;
+    if (max_depth && m_call_depth >= max_depth)
+        throw runtime::RunTimeError(
+            where,
+            std::format("Maximum call depth of {} exceeded.", max_depth));
+    if (!callee->IsPure()) ++m_effects;
+    CallDepthGuard depth_guard{m_call_depth};
+    POPL_STATS_CALL_SCOPE();
+    return callee->Call(*this, args);
 }
 
 PopLObject Interpreter::operator()(const FunctionExpr& expr, const Expr&) {
-    auto function = std::make_shared<callable::PoplFunction>(
-        &expr, m_current_environment, std::nullopt, false);
+    auto function = runtime::MakeRef<callable::PoplFunction>(
+        &expr, m_global_environment, std::nullopt, false,
+        CaptureUpvalues(expr));
 
-    return PopLObject{function};
+    return PopLObject{std::move(function)};
 }
 
 PopLObject Interpreter::Evaluate(const Expr& expr) {
@@ -220,48 +334,131 @@ PopLObject Interpreter::operator()(const SetExpr& expr, const Expr&) {
     return value;
 }
 
+PopLObject Interpreter::operator()(const ArrayExpr& expr, const Expr&) {
+    std::vector<PopLObject> elements;
+    elements.reserve(expr.elements.size());
+    for (const auto& element : expr.elements)
+        elements.emplace_back(Evaluate(*element));
+    return PopLObject{
+        std::make_shared<runtime::PoplArray>(std::move(elements))};
+}
+
+PopLObject Interpreter::operator()(const MapExpr& expr, const Expr&) {
+    auto map = std::make_shared<runtime::PoplMap>();
+    for (std::size_t i = 0; i < expr.keys.size(); ++i) {
+        PopLObject key{Evaluate(*expr.keys[i])};
+        CheckKey(expr.brace, key);
+        map->Set(std::move(key), Evaluate(*expr.values[i]));
+    }
+    return PopLObject{std::move(map)};
+}
+
+PopLObject Interpreter::operator()(const IndexExpr& expr, const Expr&) {
+    PopLObject obj{Evaluate(*expr.object)};
+    PopLObject index{Evaluate(*expr.index)};
+    if (obj.isArray()) {
+        auto& elements = obj.asArray()->GetElements();
+        return elements[CheckIndex(expr.bracket, elements.size(), index)];
+    }
+    if (obj.isMap()) {
+        CheckKey(expr.bracket, index);
+        const PopLObject* value = obj.asMap()->Find(index);
+        return value ? *value : PopLObject{NilValue{}};
+    }
+    if (obj.isFloat64Array()) {
+        auto array{obj.asFloat64Array()};
+        return PopLObject{
+            array->Data()[CheckIndex(expr.bracket, array->Size(), index)]};
+    }
+    throw runtime::RunTimeError(
+        expr.bracket, "Only arrays, maps and float64 arrays can be indexed.");
+}
+
+PopLObject Interpreter::operator()(const IndexSetExpr& expr, const Expr&) {
+    PopLObject obj{Evaluate(*expr.object)};
+    PopLObject index{Evaluate(*expr.index)};
+    if (obj.isMap()) {
+        CheckKey(expr.bracket, index);
+        PopLObject value = Evaluate(*expr.value);
+        obj.asMap()->Set(std::move(index), value);
+        return value;
+    }
+    if (obj.isFloat64Array()) {
+        auto       array{obj.asFloat64Array()};
+        auto       slot  = CheckIndex(expr.bracket, array->Size(), index);
+        PopLObject value = Evaluate(*expr.value);
+        CheckNumberOperand(expr.bracket, value);
+        array->Data()[slot] = value.asNumber();
+        return value;
+    }
+    if (!obj.isArray())
+        throw runtime::RunTimeError(
+            expr.bracket,
+            "Only arrays, maps and float64 arrays can be indexed.");
+    auto       array{obj.asArray()};
+    auto       slot  = CheckIndex(expr.bracket, array->Size(), index);
+    PopLObject value = Evaluate(*expr.value);
+    // The value expression may have shrunk the array
+    if (slot >= array->Size())
+        throw runtime::RunTimeError(expr.bracket, "Array index out of range.");
+    array->GetElements()[slot] = value;
+    return value;
+}
+
 PopLObject Interpreter::operator()(const BinaryExpr& expr, const Expr&) {
     PopLObject left  = Evaluate(*expr.left);
     PopLObject right = Evaluate(*expr.right);
+    return BinaryOperation(expr.op, left, right);
+}
+PopLObject Interpreter::BinaryOperation(const Token&      op,
+                                        const PopLObject& left,
+                                        const PopLObject& right) const {
+    CheckUninitialised(op, left);
+    CheckUninitialised(op, right);
 
-    CheckUninitialised(expr.op, left);
-    CheckUninitialised(expr.op, right);
-
-    switch (expr.op.GetType()) {
+    switch (op.GetType()) {
         case TokenType::EQUAL_EQUAL:
             return PopLObject{left == right};
         case TokenType::GREATER:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             return PopLObject{left.asNumber() > right.asNumber()};
         case TokenType::LESS:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             return PopLObject{left.asNumber() < right.asNumber()};
         case TokenType::GREATER_EQUAL:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             return PopLObject{left.asNumber() >= right.asNumber()};
         case TokenType::LESS_EQUAL:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             return PopLObject{left.asNumber() <= right.asNumber()};
         case TokenType::PLUS:
             if (left.isNumber() && right.isNumber())
                 return PopLObject{left.asNumber() + right.asNumber()};
-            if (left.isString() && right.isString())
-                return PopLObject{left.asString() + right.asString()};
-            if (left.isString() || right.isString())
-                return PopLObject{left.toString() + right.toString()};
+            if (left.isString() || right.isString()) {
+                POPL_STATS_INC(strings_concatenated);
+                // Allocation is charged by PoplString, which may defer the copy
+                auto as_string = [](const PopLObject& value) {
+                    return value.isString()
+                               ? value.asStringPtr()
+                               : std::make_shared<const runtime::PoplString>(
+                                     value.toString());
+                };
+                return PopLObject{runtime::PoplString::Concat(
+                    as_string(left), as_string(right))};
+            }
             throw runtime::RunTimeError(
-                expr.op, "Operands must be two numbers or two strings.");
+                op, "Operands must be two numbers or two strings.");
             break;
         case TokenType::MINUS:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             return PopLObject{left.asNumber() - right.asNumber()};
         case TokenType::SLASH:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             if (right.asNumber() == 0.0)
-                throw runtime::RunTimeError(expr.op, "Division by zero!");
+                throw runtime::RunTimeError(op, "Division by zero!");
             return PopLObject{left.asNumber() / right.asNumber()};
         case TokenType::STAR:
-            CheckNumberOperand(expr.op, left, right);
+            CheckNumberOperand(op, left, right);
             return PopLObject{left.asNumber() * right.asNumber()};
         case TokenType::COMMA:
             return right;
@@ -271,7 +468,68 @@ PopLObject Interpreter::operator()(const BinaryExpr& expr, const Expr&) {
     // Unreachable
     return PopLObject{NilValue{}};
 }
+/*
+ * Fused nodes: the fast paths cover numbers, anything else takes the path of
+ * the nodes they replace
+ */
+PopLObject Interpreter::operator()(const IncrementExpr& expr, const Expr&) {
+    POPL_STATS_INC(fused_increments);
+    PopLObject& slot = Variable(expr.name, expr.depth, expr.upvalue);
+    if (slot.isNumber()) [[likely]]
+        slot = PopLObject{expr.op.GetType() == TokenType::PLUS
+                              ? slot.asNumber() + expr.constant
+                              : slot.asNumber() - expr.constant};
+    else
+        slot = BinaryOperation(expr.op, slot, PopLObject{expr.constant});
+    return slot;
+}
+PopLObject Interpreter::operator()(const CompareExpr& expr, const Expr&) {
+    POPL_STATS_INC(fused_compares);
+    const PopLObject& left =
+        Variable(expr.left.name, expr.left.depth, expr.left.upvalue);
+    PopLObject        constant{expr.constant};
+    const PopLObject& right =
+        expr.right ? Variable(expr.right->name, expr.right->depth,
+                              expr.right->upvalue)
+                   : constant;
+    if (!left.isNumber() || !right.isNumber()) [[unlikely]]
+        return BinaryOperation(expr.op, left, right);
+    double a = left.asNumber(), b = right.asNumber();
+    switch (expr.op.GetType()) {
+        case TokenType::LESS:
+            return PopLObject{a < b};
+        case TokenType::LESS_EQUAL:
+            return PopLObject{a <= b};
+        case TokenType::GREATER:
+            return PopLObject{a > b};
+        default:
+            return PopLObject{a >= b};
+    }
+}
+PopLObject Interpreter::operator()(const ThisGetExpr& expr, const Expr&) {
+    POPL_STATS_INC(fused_this_gets);
+    const PopLObject& object = Variable(expr.object.keyword, expr.object.depth,
+                                        expr.object.upvalue);
+    if (object.isInstance()) return object.asInstance()->Get(expr.name);
+    throw runtime::RunTimeError(expr.name, "Only instances have properties.");
+}
+PopLObject Interpreter::operator()(const InvariantExpr& expr, const Expr&) {
+    InvariantSlot& slot = m_invariants[expr.slot];
+    if (slot.cached && slot.effects == m_effects) {
+        POPL_STATS_INC(invariants_reused);
+        return slot.value;
+    }
+    std::uint64_t effects = m_effects;
+    PopLObject    value   = Evaluate(*expr.expression);
+    // Not cached when the evaluation itself had effects, e.g. called a
+    // function that replaced a pure native
+    if (effects == m_effects) slot = {value, effects, true};
+    return value;
+}
 void Interpreter::Execute(Stmt& stmt) {
+    POPL_STATS_INC(statements_executed);
+    if (m_meter.CountStatement()) [[unlikely]]
+        CheckLimits();
     visitStmtWithArgs(
         stmt,
         [this, &stmt](auto&& contained, Stmt& originalStmt) {
@@ -290,6 +548,22 @@ void Interpreter::CheckNumberOperand(const Token& op, const PopLObject& left,
     if (left.isNumber() && right.isNumber()) return;
     throw runtime::RunTimeError(op, "Operands must be number");
 }
+std::size_t Interpreter::CheckIndex(const Token& bracket, std::size_t size,
+                                    const PopLObject& index) const {
+    if (!index.isNumber() || std::trunc(index.asNumber()) != index.asNumber())
+        throw runtime::RunTimeError(bracket, "Array index must be an integer.");
+    double position = index.asNumber();
+    if (position < 0 || position >= static_cast<double>(size))
+        throw runtime::RunTimeError(
+            bracket, std::format("Array index {} out of range for length {}.",
+                                 position, size));
+    return static_cast<std::size_t>(position);
+}
+void Interpreter::CheckKey(const Token& op, const PopLObject& key) const {
+    if (runtime::PoplMap::IsHashable(key)) return;
+    throw runtime::RunTimeError(
+        op, "Map keys must be numbers, strings or booleans.");
+}
 void Interpreter::CheckUninitialised(const Token&      op,
                                      const PopLObject& value) const {
     if (value.isUninitialized())
@@ -299,19 +573,75 @@ Token Interpreter::MakeReplReadToken(std::string_view what) const {
     return Token{TokenType::IDENTIFIER, std::string(what),
                  PopLObject{NilValue{}}, 1};
 }
+void Interpreter::CheckLimits() {
+    auto exceeded = m_meter.Check();
+    if (exceeded != runtime::ResourceMeter::Exceeded::NONE)
+        throw LimitError(exceeded);
+}
+runtime::RunTimeError Interpreter::LimitError(
+    runtime::ResourceMeter::Exceeded exceeded) const {
+    const auto& limits = m_meter.GetLimits();
+    std::string message;
+    switch (exceeded) {
+        case runtime::ResourceMeter::Exceeded::NONE:
+            break;
+        case runtime::ResourceMeter::Exceeded::STATEMENTS:
+            message = std::format("Statement limit of {} exceeded.",
+                                  limits.max_statements);
+            break;
+        case runtime::ResourceMeter::Exceeded::WALL_TIME:
+            message = std::format("Time limit of {} ms exceeded.",
+                                  limits.max_wall_time.count());
+            break;
+        case runtime::ResourceMeter::Exceeded::ALLOCATION:
+            message = std::format("Allocation limit of {} bytes exceeded.",
+                                  limits.max_alloc_bytes);
+            break;
+    }
+    return runtime::RunTimeError(
+        Token{TokenType::IDENTIFIER, "<limit>", PopLObject{NilValue{}}, 0},
+        message);
+}
+void Interpreter::RunEventLoop() {
+    if (m_event_loop && !m_event_loop->Run(m_meter.GetDeadline()))
+        throw LimitError(runtime::ResourceMeter::Exceeded::WALL_TIME);
+}
 void Interpreter::ExecuteBlock(const std::vector<std::unique_ptr<Stmt>>& stmts,
-                               std::shared_ptr<Environment> newEnv) {
-    auto previous = m_current_environment;
+                               runtime::Ref<Environment> newEnv) {
+    auto previous = std::exchange(m_current_environment, std::move(newEnv));
     try {
-        m_current_environment = newEnv;
         for (const auto& stmt : stmts) {
             Execute(*stmt);
         }
     } catch (...) {
-        m_current_environment = previous;
+        m_current_environment = std::move(previous);
         throw;
     }
-    m_current_environment = previous;
+    m_current_environment = std::move(previous);
+}
+void Interpreter::ExecuteFunction(
+    const std::vector<std::unique_ptr<Stmt>>& body,
+    runtime::Ref<Environment>                 env,
+    std::span<const runtime::Ref<Cell>>       upvalues) {
+    // Restored by a destructor rather than catch and rethrow, as every
+    // `return` unwinds through here
+    struct Restore {
+        std::span<const runtime::Ref<Cell>>& upvalues;
+        std::span<const runtime::Ref<Cell>>  previous;
+        ~Restore() { upvalues = previous; }
+    } restore{m_upvalues, std::exchange(m_upvalues, upvalues)};
+    ExecuteBlock(body, std::move(env));
+}
+Upvalues Interpreter::CaptureUpvalues(const FunctionExpr& function) {
+    // From the pool the closure is allocated from
+    Upvalues cells{runtime::CurrentResource()};
+    cells.reserve(function.upvalues.size());
+    for (const auto& upvalue : function.upvalues) {
+        cells.push_back(upvalue.isLocal ? m_current_environment->CaptureAt(
+                                              upvalue.index, upvalue.name)
+                                        : m_upvalues[upvalue.index]);
+    }
+    return cells;
 }
 
 const PopLObject& Interpreter::LookUpVariable(const Token& name,
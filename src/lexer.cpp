@@ -29,7 +29,7 @@ void Lexer::ScanStringLiteral() {
         Advance();
     }
     if (ReachedEnd()) {
-        Diagnostics::Error(m_line, "Unterminated String");
+        m_diagnostics.Error(m_line, "Unterminated String");
         return;
     }
     Advance();  // closing "
@@ -68,7 +68,7 @@ void Lexer::SkipBlockComment() {
         Advance();
     }
     if (!Done) {
-        Diagnostics::Error(lineStart, "Block Comment End Not Found");
+        m_diagnostics.Error(lineStart, "Block Comment End Not Found");
     }
 }
 
@@ -96,6 +96,12 @@ void Lexer::ScanToken() {
         case '}':
             AddToken(TokenType::RIGHT_BRACE);
             break;
+        case '[':
+            AddToken(TokenType::LEFT_BRACKET);
+            break;
+        case ']':
+            AddToken(TokenType::RIGHT_BRACKET);
+            break;
         case ',':
             AddToken(TokenType::COMMA);
             break;
@@ -160,7 +166,7 @@ void Lexer::ScanToken() {
             } else if (IsAlphaOrUnderScore(c)) {
                 ScanIdentifier();
             } else {
-                Diagnostics::Error(m_line, "Unexpected character");
+                m_diagnostics.Error(m_line, "Unexpected character");
             }
             break;
     }
@@ -0,0 +1,342 @@
+#include "popl/syntax/visitors/loop_invariants.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "popl/callables/callable.hpp"
+#include "popl/environment.hpp"
+#include "popl/syntax/ast/expr.hpp"
+#include "popl/syntax/ast/stmt.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
+
+namespace popl {
+
+namespace {
+// Everything a tree assigns, declares, calls or stores into
+struct EffectsCollector {
+    LoopInvariants::Effects& effects;
+
+    void Collect(const Expr& expr) { visitExprWithArgs(expr, *this); }
+    void Collect(const Stmt& stmt) { visitStmtWithArgs(stmt, *this); }
+    void Collect(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+        for (const auto& stmt : stmts)
+            if (stmt) Collect(*stmt);
+    }
+    void Collect(const std::unique_ptr<Expr>& expr) {
+        if (expr) Collect(*expr);
+    }
+    void Collect(const std::unique_ptr<Stmt>& stmt) {
+        if (stmt) Collect(*stmt);
+    }
+    void Function(const FunctionExpr& function) {
+        for (const auto& param : function.params)
+            effects.assigned.insert(param.GetLexeme());
+        Collect(function.body);
+    }
+
+    // Expressions
+    void operator()(const NilExpr&) {}
+    void operator()(const LiteralExpr&) {}
+    void operator()(const VariableExpr&) {}
+    void operator()(const ThisExpr&) {}
+    void operator()(const BinaryExpr& e) {
+        Collect(e.left);
+        Collect(e.right);
+    }
+    void operator()(const LogicalExpr& e) {
+        Collect(e.left);
+        Collect(e.right);
+    }
+    void operator()(const TernaryExpr& e) {
+        Collect(e.condition);
+        Collect(e.thenBranch);
+        Collect(e.elseBranch);
+    }
+    void operator()(const GroupingExpr& e) { Collect(e.expression); }
+    void operator()(const UnaryExpr& e) { Collect(e.right); }
+    void operator()(const CallExpr& e) {
+        effects.calls.push_back(&e);
+        Collect(e.callee);
+        for (const auto& arg : e.arguments) Collect(arg);
+    }
+    void operator()(const FunctionExpr& e) { Function(e); }
+    void operator()(const GetExpr& e) { Collect(e.object); }
+    void operator()(const SetExpr& e) {
+        effects.stores = true;
+        Collect(e.object);
+        Collect(e.value);
+    }
+    void operator()(const AssignExpr& e) {
+        effects.assigned.insert(e.name.GetLexeme());
+        Collect(e.value);
+    }
+    void operator()(const ArrayExpr& e) {
+        for (const auto& element : e.elements) Collect(element);
+    }
+    void operator()(const IndexExpr& e) {
+        Collect(e.object);
+        Collect(e.index);
+    }
+    void operator()(const MapExpr& e) {
+        for (const auto& key : e.keys) Collect(key);
+        for (const auto& value : e.values) Collect(value);
+    }
+    void operator()(const IndexSetExpr& e) {
+        effects.stores = true;
+        Collect(e.object);
+        Collect(e.index);
+        Collect(e.value);
+    }
+    void operator()(const IncrementExpr& e) {
+        effects.assigned.insert(e.name.GetLexeme());
+    }
+    void operator()(const CompareExpr&) {}
+    void operator()(const ThisGetExpr&) {}
+    void operator()(const InvariantExpr& e) { Collect(e.expression); }
+
+    // Statements
+    void operator()(const NilStmt&) {}
+    void operator()(const BreakStmt&) {}
+    void operator()(const ContinueStmt&) {}
+    void operator()(const BlockStmt& s) { Collect(s.statements); }
+    void operator()(const ExpressionStmt& s) { Collect(s.expression); }
+    void operator()(const VarStmt& s) {
+        effects.assigned.insert(s.name.GetLexeme());
+        Collect(s.initializer);
+    }
+    void operator()(const IfStmt& s) {
+        Collect(s.condition);
+        Collect(s.thenBranch);
+        Collect(s.elseBranch);
+    }
+    void operator()(const WhileStmt& s) {
+        Collect(s.condition);
+        Collect(s.body);
+    }
+    void operator()(const ReturnStmt& s) { Collect(s.value); }
+    void operator()(const FunctionStmt& s) {
+        effects.assigned.insert(s.name.GetLexeme());
+        Function(*s.func);
+    }
+    void operator()(const ClassStmt& s) {
+        effects.assigned.insert(s.name.GetLexeme());
+        for (const auto& method : s.methods) Function(*method->func);
+    }
+};
+
+// Whether evaluating `expr` does more than read a value, so that caching it
+// saves work
+bool DoesWork(const Expr& expr) {
+    if (auto* grouping = std::get_if<GroupingExpr>(&expr.node))
+        return DoesWork(*grouping->expression);
+    return !std::holds_alternative<LiteralExpr>(expr.node) &&
+           !std::holds_alternative<VariableExpr>(expr.node) &&
+           !std::holds_alternative<ThisExpr>(expr.node) &&
+           !std::holds_alternative<NilExpr>(expr.node);
+}
+}  // namespace
+
+LoopInvariants::LoopInvariants(const Interpreter& interpreter)
+    : m_globals{*interpreter.GetGlobalEnvironment()} {}
+
+void LoopInvariants::Optimize(std::vector<std::unique_ptr<Stmt>>& statements) {
+    Effects effects;
+    EffectsCollector{effects}.Collect(statements);
+    m_rebound = std::move(effects.assigned);
+    for (auto& stmt : statements)
+        if (stmt) Optimize(*stmt);
+}
+void LoopInvariants::Optimize(Stmt& stmt) {
+    visitStmtWithArgs(
+        stmt,
+        [this](auto&& contained, Stmt& originalStmt) {
+            return (*this)(contained, originalStmt);
+        },
+        stmt);
+}
+void LoopInvariants::Optimize(Expr& expr) {
+    visitExprWithArgs(
+        expr,
+        [this](auto&& contained, Expr& originalExpr) {
+            return (*this)(contained, originalExpr);
+        },
+        expr);
+}
+void LoopInvariants::Hoist(Expr& expr) {
+    if (m_loop && DoesWork(expr) && IsInvariant(expr)) {
+        auto hoisted = std::make_unique<Expr>(std::move(expr));
+        expr.node    = InvariantExpr{std::move(hoisted), m_loop->slots++};
+        return;
+    }
+    Optimize(expr);
+}
+void LoopInvariants::OptimizeFunction(FunctionExpr& function) {
+    Loop* enclosing = std::exchange(m_loop, nullptr);
+    for (auto& stmt : function.body) Optimize(*stmt);
+    m_loop = enclosing;
+}
+
+bool LoopInvariants::IsPureNative(const Expr& callee) const {
+    auto* variable = std::get_if<VariableExpr>(&callee.node);
+    if (!variable || variable->depth || variable->upvalue) return false;
+    const std::string& name = variable->name.GetLexeme();
+    if (m_rebound.contains(name)) return false;
+    auto it = m_globals.GetValues().find(name);
+    return it != m_globals.GetValues().end() && it->second.isCallable() &&
+           it->second.asCallable()->IsPure();
+}
+
+bool LoopInvariants::IsInvariant(const Expr& expr) const {
+    const Effects& effects = m_loop->effects;
+    return std::visit(
+        [&](const auto& node) -> bool {
+            using T = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<T, LiteralExpr> ||
+                          std::is_same_v<T, NilExpr> ||
+                          std::is_same_v<T, ThisExpr>)
+                return true;
+            else if constexpr (std::is_same_v<T, VariableExpr>)
+                return !effects.assigned.contains(node.name.GetLexeme());
+            else if constexpr (std::is_same_v<T, GroupingExpr>)
+                return IsInvariant(*node.expression);
+            else if constexpr (std::is_same_v<T, UnaryExpr>)
+                return IsInvariant(*node.right);
+            else if constexpr (std::is_same_v<T, BinaryExpr> ||
+                               std::is_same_v<T, LogicalExpr>)
+                return IsInvariant(*node.left) && IsInvariant(*node.right);
+            else if constexpr (std::is_same_v<T, TernaryExpr>)
+                return IsInvariant(*node.condition) &&
+                       IsInvariant(*node.thenBranch) &&
+                       IsInvariant(*node.elseBranch);
+            // Reads of objects, which only stores in the loop could change
+            else if constexpr (std::is_same_v<T, GetExpr>)
+                return !effects.stores && IsInvariant(*node.object);
+            else if constexpr (std::is_same_v<T, IndexExpr>)
+                return !effects.stores && IsInvariant(*node.object) &&
+                       IsInvariant(*node.index);
+            else if constexpr (std::is_same_v<T, CallExpr>)
+                return !effects.stores && IsInvariant(*node.callee) &&
+                       IsPureNative(*node.callee) &&
+                       std::ranges::all_of(node.arguments,
+                                           [this](const auto& arg) {
+                                               return IsInvariant(*arg);
+                                           });
+            else
+                return false;
+        },
+        expr.node);
+}
+
+/*
+ * Statements
+ */
+void LoopInvariants::operator()(ExpressionStmt& stmt, Stmt&) {
+    Hoist(*stmt.expression);
+}
+void LoopInvariants::operator()(NilStmt&, Stmt&) {}
+void LoopInvariants::operator()(VarStmt& stmt, Stmt&) {
+    if (stmt.initializer) Hoist(*stmt.initializer);
+}
+void LoopInvariants::operator()(BlockStmt& stmt, Stmt&) {
+    for (auto& statement : stmt.statements) Optimize(*statement);
+}
+void LoopInvariants::operator()(IfStmt& stmt, Stmt&) {
+    Hoist(*stmt.condition);
+    Optimize(*stmt.thenBranch);
+    if (stmt.elseBranch) Optimize(*stmt.elseBranch);
+}
+void LoopInvariants::operator()(WhileStmt& stmt, Stmt&) {
+    Loop            loop;
+    EffectsCollector collector{loop.effects};
+    collector.Collect(*stmt.condition);
+    collector.Collect(*stmt.body);
+    // Any other call may change what the loop reads
+    bool hoists = std::ranges::all_of(
+        loop.effects.calls,
+        [this](const CallExpr* call) { return IsPureNative(*call->callee); });
+
+    // Nested loops hoist into their own caches
+    Loop* enclosing = std::exchange(m_loop, hoists ? &loop : nullptr);
+    Hoist(*stmt.condition);
+    Optimize(*stmt.body);
+    m_loop          = enclosing;
+    stmt.invariants = loop.slots;
+}
+void LoopInvariants::operator()(BreakStmt&, Stmt&) {}
+void LoopInvariants::operator()(ContinueStmt&, Stmt&) {}
+void LoopInvariants::operator()(ReturnStmt& stmt, Stmt&) {
+    if (stmt.value) Hoist(*stmt.value);
+}
+void LoopInvariants::operator()(FunctionStmt& stmt, Stmt&) {
+    OptimizeFunction(*stmt.func);
+}
+void LoopInvariants::operator()(ClassStmt& stmt, Stmt&) {
+    for (auto& method : stmt.methods) OptimizeFunction(*method->func);
+}
+
+/*
+ * Expressions, reached when not invariant as a whole
+ */
+void LoopInvariants::operator()(LiteralExpr&, Expr&) {}
+void LoopInvariants::operator()(GroupingExpr& expr, Expr&) {
+    Hoist(*expr.expression);
+}
+void LoopInvariants::operator()(TernaryExpr& expr, Expr&) {
+    Hoist(*expr.condition);
+    Hoist(*expr.thenBranch);
+    Hoist(*expr.elseBranch);
+}
+void LoopInvariants::operator()(UnaryExpr& expr, Expr&) { Hoist(*expr.right); }
+void LoopInvariants::operator()(BinaryExpr& expr, Expr&) {
+    Hoist(*expr.left);
+    Hoist(*expr.right);
+}
+void LoopInvariants::operator()(VariableExpr&, Expr&) {}
+void LoopInvariants::operator()(NilExpr&, Expr&) {}
+void LoopInvariants::operator()(LogicalExpr& expr, Expr&) {
+    Hoist(*expr.left);
+    Hoist(*expr.right);
+}
+void LoopInvariants::operator()(CallExpr& expr, Expr&) {
+    Hoist(*expr.callee);
+    for (auto& arg : expr.arguments) Hoist(*arg);
+}
+void LoopInvariants::operator()(AssignExpr& expr, Expr&) {
+    Hoist(*expr.value);
+}
+void LoopInvariants::operator()(FunctionExpr& expr, Expr&) {
+    OptimizeFunction(expr);
+}
+void LoopInvariants::operator()(GetExpr& expr, Expr&) { Hoist(*expr.object); }
+void LoopInvariants::operator()(SetExpr& expr, Expr&) {
+    Hoist(*expr.object);
+    Hoist(*expr.value);
+}
+void LoopInvariants::operator()(ThisExpr&, Expr&) {}
+void LoopInvariants::operator()(ArrayExpr& expr, Expr&) {
+    for (auto& element : expr.elements) Hoist(*element);
+}
+void LoopInvariants::operator()(IndexExpr& expr, Expr&) {
+    Hoist(*expr.object);
+    Hoist(*expr.index);
+}
+void LoopInvariants::operator()(IndexSetExpr& expr, Expr&) {
+    Hoist(*expr.object);
+    Hoist(*expr.index);
+    Hoist(*expr.value);
+}
+void LoopInvariants::operator()(MapExpr& expr, Expr&) {
+    for (std::size_t i = 0; i < expr.keys.size(); ++i) {
+        Hoist(*expr.keys[i]);
+        Hoist(*expr.values[i]);
+    }
+}
+void LoopInvariants::operator()(IncrementExpr&, Expr&) {}
+void LoopInvariants::operator()(CompareExpr&, Expr&) {}
+void LoopInvariants::operator()(ThisGetExpr&, Expr&) {}
+void LoopInvariants::operator()(InvariantExpr&, Expr&) {}
+
+}  // namespace popl
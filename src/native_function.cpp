@@ -1,16 +1,32 @@
+#include <format>
+
 #include "popl/callables/native_functions.hpp"
 #include "popl/literal.hpp"
+#include "popl/runtime/run_time_error.hpp"
+#include "popl/runtime/tracer.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
 
 namespace popl::callable {
 
-NativeFunction::NativeFunction(std::string name, int arity, FnType fn)
-    : m_name(std::move(name)), m_arity(arity), m_function(std::move(fn)) {}
+NativeFunction::NativeFunction(std::string name, int arity, FnType fn,
+                               bool pure)
+    : m_name(std::move(name)), m_arity(arity), m_function(fn), m_pure(pure) {}
 
 int NativeFunction::GetArity() const { return m_arity; }
 
-PopLObject NativeFunction::Call(Interpreter&                   interpreter,
-                                const std::vector<PopLObject>& args) {
-    return m_function(interpreter, args);
+PopLObject NativeFunction::Call(Interpreter&                interpreter,
+                                std::span<const PopLObject> args) {
+    runtime::TraceScope trace{interpreter.GetTracer(), m_name,
+                              runtime::TraceCategory::NATIVE_CALL};
+    try {
+        return m_function(interpreter, args);
+    } catch (const NativeArgumentError& error) {
+        throw runtime::RunTimeError(
+            Token{TokenType::IDENTIFIER, m_name, PopLObject{NilValue{}}, 0},
+            std::format("{}() expects {} as argument {}, got '{}'.", m_name,
+                        error.expected, error.index + 1,
+                        args[error.index].toString()));
+    }
 }
 
 std::string NativeFunction::ToString() const {
@@ -1,14 +1,37 @@
 #include "popl/callables/native_registry.hpp"
 
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <format>
 #include <iostream>
 #include <memory>
-#include <print>
+#include <new>
 #include <string>
 
+#include "popl/callables/native_binding.hpp"
 #include "popl/callables/native_functions.hpp"
 #include "popl/environment.hpp"
 #include "popl/literal.hpp"
+#include "popl/runtime/event_loop.hpp"
+#include "popl/runtime/file_table.hpp"
+#include "popl/runtime/float64_array.hpp"
+#include "popl/runtime/parallel.hpp"
+#include "popl/runtime/popl_array.hpp"
+#include "popl/runtime/popl_map.hpp"
+#include "popl/runtime/run_time_error.hpp"
+#include "popl/runtime/transfer.hpp"
+#include "popl/runtime/vector_kernels.hpp"
+#include "popl/runtime/workers.hpp"
 #include "popl/syntax/visitors/interpreter.hpp"
 
 namespace popl {
@@ -20,39 +43,857 @@ static Token MakeBuiltinToken(std::string_view name) {
                  PopLObject{NilValue{}}, 0};
 }
 
-static void Register(Interpreter& interpreter, std::shared_ptr<Environment> env,
-                     std::string name, int arity, NativeFunction::FnType fn) {
+// Worker and channel ids are positive integers handed out by WorkerGroup
+static runtime::WorkerGroup::Id ToId(std::string_view native,
+                                    const PopLObject& value) {
+    if (value.isNumber()) {
+        double id = value.asNumber();
+        if (id >= 1 && id <= UINT32_MAX && std::trunc(id) == id)
+            return static_cast<runtime::WorkerGroup::Id>(id);
+    }
+    throw runtime::RunTimeError(
+        MakeBuiltinToken(native),
+        std::format("{}() expects an id, got '{}'.", native, value.toString()));
+}
+
+// Longest array a native builds from a length argument: 1 GiB of doubles
+static constexpr std::size_t kMaxLength = std::size_t{1} << 27;
+
+static std::size_t ToLength(std::string_view native, const PopLObject& value) {
+    double length = value.asNumber();
+    if (length >= 0 && length <= static_cast<double>(kMaxLength) &&
+        std::trunc(length) == length)
+        return static_cast<std::size_t>(length);
+    throw runtime::RunTimeError(
+        MakeBuiltinToken(native),
+        std::format("{}() expects a whole length of at most {}, got '{}'.",
+                    native, kMaxLength, value.toString()));
+}
+
+static std::shared_ptr<runtime::Channel> GetChannel(
+    Interpreter& interpreter, std::string_view native, const PopLObject& id) {
+    auto channel = interpreter.GetWorkerGroup().GetChannel(ToId(native, id));
+    if (!channel)
+        throw runtime::RunTimeError(MakeBuiltinToken(native),
+                                    std::format("Unknown channel {}.", id));
+    return channel;
+}
+
+static runtime::File& GetFile(Interpreter& interpreter, std::string_view native,
+                              const PopLObject& id, bool readable) {
+    runtime::File* file = interpreter.GetFiles().Get(ToId(native, id));
+    if (!file)
+        throw runtime::RunTimeError(
+            MakeBuiltinToken(native),
+            std::format("Unknown or closed file {}.", id));
+    if (file->IsReadable() != readable)
+        throw runtime::RunTimeError(
+            MakeBuiltinToken(native),
+            std::format("{}() on a file opened for {}.", native,
+                        readable ? "writing" : "reading"));
+    return *file;
+}
+
+static void CheckCallback(std::string_view native, const PopLObject& callback,
+                          int arity) {
+    if (callback.isCallable() && callback.asCallable()->GetArity() == arity)
+        return;
+    throw runtime::RunTimeError(
+        MakeBuiltinToken(native),
+        std::format("{}() expects a callback taking {} argument(s).", native,
+                    arity));
+}
+
+// Natives that reach outside the interpreter need the host's permission
+static void CheckAllowed(std::string_view native, bool allowed,
+                         std::string_view option) {
+    if (allowed) return;
+    throw runtime::RunTimeError(
+        MakeBuiltinToken(native),
+        std::format("{}() is off by default; run with {} to enable it.",
+                    native, option));
+}
+
+static const PopLObject& CheckKey(std::string_view  native,
+                                  const PopLObject& key) {
+    if (runtime::PoplMap::IsHashable(key)) return key;
+    throw runtime::RunTimeError(
+        MakeBuiltinToken(native),
+        std::format("{}() keys must be numbers, strings or booleans.", native));
+}
+
+// Collects one array element per map entry
+template <typename Project>
+static PopLObject::ArrayPtr CollectEntries(const runtime::PoplMap& map,
+                                           Project                 project) {
+    std::vector<PopLObject> elements;
+    elements.reserve(map.Size());
+    map.ForEach([&](const PopLObject& key, const PopLObject& value) {
+        elements.push_back(project(key, value));
+    });
+    return std::make_shared<runtime::PoplArray>(std::move(elements));
+}
+
+static void CheckSameSize(std::string_view             native,
+                          const runtime::Float64Array& x,
+                          const runtime::Float64Array& y) {
+    if (x.Size() == y.Size()) return;
+    throw runtime::RunTimeError(
+        MakeBuiltinToken(native),
+        std::format("{}() expects arrays of the same length, got {} and {}.",
+                    native, x.Size(), y.Size()));
+}
+
+// Clamps a slice bound to [0, size]; negative bounds count from the end
+static std::size_t SliceBound(double bound, std::size_t size) {
+    double position = std::trunc(bound);
+    if (position < 0) position += static_cast<double>(size);
+    return static_cast<std::size_t>(
+        std::clamp(position, 0.0, static_cast<double>(size)));
+}
+
+/*
+ * Typed natives, registered through native_binding.hpp: argument types are
+ * checked before the body runs.
+ */
+namespace {
+using ArrayPtr        = PopLObject::ArrayPtr;
+using CallablePtr     = PopLObject::CallablePtr;
+using Float64ArrayPtr = PopLObject::Float64ArrayPtr;
+using MapPtr          = PopLObject::MapPtr;
+
+double Clock() {
+    using namespace std::chrono;
+    auto now = system_clock::now().time_since_epoch();
+    return duration<double>(now).count();
+}
+void Print(Interpreter& interpreter, const PopLObject& value) {
+    interpreter.GetOutput().WriteLine(value.toString());
+}
+void Flush(Interpreter& interpreter) { interpreter.GetOutput().Flush(); }
+// Flushes first so that a prompt printed without a newline is visible
+std::string Input(Interpreter& interpreter) {
+    interpreter.GetOutput().Flush();
+    std::string line;
+    std::getline(std::cin, line);
+    return line;
+}
+
+double OpenFile(Interpreter& interpreter, const std::string& path,
+                std::string_view mode) {
+    CheckAllowed("openFile", interpreter.GetLimits().allow_files,
+                 "--allow-files");
+    using Mode = runtime::File::Mode;
+    if (mode != "r" && mode != "w" && mode != "a")
+        throw runtime::RunTimeError(
+            MakeBuiltinToken("openFile"),
+            std::format("openFile() mode must be 'r', 'w' or 'a', got '{}'.",
+                        mode));
+    Mode file_mode = mode == "r"   ? Mode::READ
+                     : mode == "w" ? Mode::WRITE
+                                   : Mode::APPEND;
+    auto file      = runtime::File::Open(path, file_mode);
+    if (!file)
+        throw runtime::RunTimeError(MakeBuiltinToken("openFile"),
+                                    std::format("Failed to open '{}': {}.",
+                                                path, std::strerror(errno)));
+    return interpreter.GetFiles().Add(std::move(file));
+}
+PopLObject ReadLine(Interpreter& interpreter, const PopLObject& file) {
+    auto line = GetFile(interpreter, "readLine", file, true).ReadLine();
+    return line ? PopLObject{std::move(*line)} : PopLObject{NilValue{}};
+}
+PopLObject ReadChunk(Interpreter& interpreter, const PopLObject& file,
+                     double size) {
+    if (!(size >= 1))
+        throw runtime::RunTimeError(MakeBuiltinToken("readChunk"),
+                                    "readChunk() size must be positive.");
+    // Larger sizes don't fit a size_t; reads are capped well below anyway
+    std::size_t max = size < 0x1p64 ? static_cast<std::size_t>(size) : SIZE_MAX;
+    auto chunk = GetFile(interpreter, "readChunk", file, true).ReadChunk(max);
+    if (!chunk)
+        throw runtime::RunTimeError(
+            MakeBuiltinToken("readChunk"),
+            std::format("Failed to read: {}.", std::strerror(errno)));
+    if (chunk->empty()) return PopLObject{NilValue{}};
+    runtime::ChargeAlloc(chunk->size());
+    return PopLObject{std::move(*chunk)};
+}
+void Write(Interpreter& interpreter, const PopLObject& file,
+           std::string_view text) {
+    GetFile(interpreter, "write", file, false).Write(text);
+}
+void WriteLine(Interpreter& interpreter, const PopLObject& file,
+               std::string_view text) {
+    auto& output = GetFile(interpreter, "writeLine", file, false);
+    output.Write(text);
+    output.Write("\n");
+}
+void CloseFile(Interpreter& interpreter, const PopLObject& file) {
+    if (!interpreter.GetFiles().Close(ToId("closeFile", file)))
+        throw runtime::RunTimeError(
+            MakeBuiltinToken("closeFile"),
+            std::format("Unknown or closed file {}.", file));
+}
+std::string ReadFile(Interpreter& interpreter, const std::string& path) {
+    CheckAllowed("readFile", interpreter.GetLimits().allow_files,
+                 "--allow-files");
+    auto contents = runtime::ReadWholeFile(path);
+    if (!contents)
+        throw runtime::RunTimeError(MakeBuiltinToken("readFile"),
+                                    std::format("Failed to read '{}': {}.",
+                                                path, std::strerror(errno)));
+    return std::move(*contents);
+}
+
+double Sqrt(double x) { return std::sqrt(x); }
+double Floor(double x) { return std::floor(x); }
+double Abs(double x) { return std::fabs(x); }
+double Pow(double base, double exponent) { return std::pow(base, exponent); }
+
+double Push(ArrayPtr array, const PopLObject& value) {
+    array->Push(value);
+    return static_cast<double>(array->Size());
+}
+PopLObject Pop(ArrayPtr array) {
+    auto& elements = array->GetElements();
+    if (elements.empty())
+        throw runtime::RunTimeError(MakeBuiltinToken("pop"),
+                                    "pop() from an empty array.");
+    PopLObject last = std::move(elements.back());
+    elements.pop_back();
+    return last;
+}
+ArrayPtr Slice(ArrayPtr array, double begin, double end) {
+    const auto& elements = array->GetElements();
+    auto        first    = SliceBound(begin, elements.size());
+    auto        last     = SliceBound(end, elements.size());
+    std::vector<PopLObject> copy;
+    if (first < last)
+        copy.assign(elements.begin() + first, elements.begin() + last);
+    return std::make_shared<runtime::PoplArray>(std::move(copy));
+}
+ArrayPtr Sort(ArrayPtr array) {
+    auto& elements = array->GetElements();
+    if (std::ranges::all_of(elements, &PopLObject::isNumber)) {
+        // NaN is unordered, and sorting with < over it is undefined
+        if (std::ranges::any_of(elements, [](const PopLObject& value) {
+                return std::isnan(value.asNumber());
+            }))
+            throw runtime::RunTimeError(MakeBuiltinToken("sort"),
+                                        "sort() cannot order NaN.");
+        std::ranges::sort(elements, {}, &PopLObject::asNumber);
+    } else if (std::ranges::all_of(elements, &PopLObject::isString)) {
+        std::ranges::sort(elements, {}, [](const PopLObject& value) {
+            return std::string_view{value.asString()};
+        });
+    } else {
+        throw runtime::RunTimeError(
+            MakeBuiltinToken("sort"),
+            "sort() expects an array of numbers or of strings.");
+    }
+    return array;
+}
+// Builds the result in one buffer; the usual way to assemble a large string
+// from pieces pushed onto an array
+std::string Join(ArrayPtr array, std::string_view separator) {
+    const auto& elements = array->GetElements();
+    std::size_t size     = 0;
+    for (const auto& element : elements)
+        if (element.isString()) size += element.asStringPtr()->Size();
+    std::string joined;
+    joined.reserve(size + separator.size() * elements.size());
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        if (i) joined.append(separator);
+        if (elements[i].isString())
+            joined.append(elements[i].asString());
+        else
+            joined.append(elements[i].toString());
+    }
+    runtime::ChargeAlloc(joined.size());
+    return joined;
+}
+// The callback may resize the array, so map and filter re-check the size on
+// every step
+ArrayPtr Map(Interpreter& interpreter, ArrayPtr array, CallablePtr fn) {
+    CheckCallback("map", PopLObject{fn}, 1);
+    std::vector<PopLObject> mapped;
+    mapped.reserve(array->Size());
+    for (std::size_t i = 0; i < array->Size(); ++i) {
+        PopLObject element = array->GetElements()[i];
+        mapped.emplace_back(interpreter.CallBack("map", fn, {&element, 1}));
+    }
+    return std::make_shared<runtime::PoplArray>(std::move(mapped));
+}
+ArrayPtr Filter(Interpreter& interpreter, ArrayPtr array, CallablePtr fn) {
+    CheckCallback("filter", PopLObject{fn}, 1);
+    std::vector<PopLObject> kept;
+    for (std::size_t i = 0; i < array->Size(); ++i) {
+        PopLObject element = array->GetElements()[i];
+        if (interpreter.CallBack("filter", fn, {&element, 1}).isTruthy())
+            kept.emplace_back(std::move(element));
+    }
+    return std::make_shared<runtime::PoplArray>(std::move(kept));
+}
+
+bool Has(MapPtr map, const PopLObject& key) {
+    return map->Find(CheckKey("has", key)) != nullptr;
+}
+PopLObject Get(MapPtr map, const PopLObject& key) {
+    const PopLObject* value = map->Find(CheckKey("get", key));
+    return value ? *value : PopLObject{NilValue{}};
+}
+PopLObject Set(MapPtr map, const PopLObject& key, const PopLObject& value) {
+    map->Set(CheckKey("set", key), value);
+    return value;
+}
+bool Delete(MapPtr map, const PopLObject& key) {
+    return map->Erase(CheckKey("delete", key));
+}
+ArrayPtr Keys(MapPtr map) {
+    return CollectEntries(
+        *map, [](const PopLObject& key, const PopLObject&) { return key; });
+}
+ArrayPtr Values(MapPtr map) {
+    return CollectEntries(
+        *map, [](const PopLObject&, const PopLObject& value) { return value; });
+}
+ArrayPtr Entries(MapPtr map) {
+    return CollectEntries(*map, [](const PopLObject& key,
+                                   const PopLObject& value) {
+        return PopLObject{std::make_shared<runtime::PoplArray>(
+            std::vector<PopLObject>{key, value})};
+    });
+}
+
+ArrayPtr ToArray(Float64ArrayPtr array) {
+    std::vector<PopLObject> elements;
+    elements.reserve(array->Size());
+    for (std::size_t i = 0; i < array->Size(); ++i)
+        elements.emplace_back(array->Data()[i]);
+    return std::make_shared<runtime::PoplArray>(std::move(elements));
+}
+double Sum(Float64ArrayPtr x) {
+    return runtime::VectorKernels::Get().sum(x->Data(), x->Size());
+}
+double Dot(Float64ArrayPtr x, Float64ArrayPtr y) {
+    CheckSameSize("dot", *x, *y);
+    return runtime::VectorKernels::Get().dot(x->Data(), y->Data(), x->Size());
+}
+Float64ArrayPtr Axpy(double alpha, Float64ArrayPtr x, Float64ArrayPtr y) {
+    CheckSameSize("axpy", *x, *y);
+    runtime::VectorKernels::Get().axpy(alpha, x->Data(), y->Data(), x->Size());
+    return y;
+}
+Float64ArrayPtr VecAdd(Float64ArrayPtr x, Float64ArrayPtr y) {
+    CheckSameSize("vecAdd", *x, *y);
+    auto out = std::make_shared<runtime::Float64Array>(x->Size());
+    runtime::VectorKernels::Get().add(x->Data(), y->Data(), out->Data(),
+                                      x->Size());
+    return out;
+}
+Float64ArrayPtr VecMul(Float64ArrayPtr x, Float64ArrayPtr y) {
+    CheckSameSize("vecMul", *x, *y);
+    auto out = std::make_shared<runtime::Float64Array>(x->Size());
+    runtime::VectorKernels::Get().mul(x->Data(), y->Data(), out->Data(),
+                                      x->Size());
+    return out;
+}
+PopLObject VecMin(Float64ArrayPtr x) {
+    if (x->Size() == 0) return PopLObject{NilValue{}};
+    return PopLObject(runtime::VectorKernels::Get().min(x->Data(), x->Size()));
+}
+PopLObject VecMax(Float64ArrayPtr x) {
+    if (x->Size() == 0) return PopLObject{NilValue{}};
+    return PopLObject(runtime::VectorKernels::Get().max(x->Data(), x->Size()));
+}
+Float64ArrayPtr PrefixSum(Float64ArrayPtr x) {
+    auto out = std::make_shared<runtime::Float64Array>(x->Size());
+    runtime::VectorKernels::Get().prefix_sum(x->Data(), out->Data(),
+                                             x->Size());
+    return out;
+}
+}  // namespace
+
+/*
+ * Async natives: each one starts a coroutine on the interpreter's event loop
+ * and returns nil at once; the callback runs from the loop when the result is
+ * ready.
+ */
+namespace {
+using runtime::AsyncTask;
+using runtime::EventLoop;
+
+class FileDescriptor {
+   public:
+    explicit FileDescriptor(int fd) : m_fd{fd} {}
+    ~FileDescriptor() {
+        if (m_fd >= 0) close(m_fd);
+    }
+    FileDescriptor(const FileDescriptor&)            = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    int Get() const { return m_fd; }
+
+   private:
+    int m_fd;
+};
+
+// Terminates and reaps the child if the task is dropped before it exited
+class ChildProcess {
+   public:
+    explicit ChildProcess(pid_t pid) : m_pid{pid} {}
+    ~ChildProcess() {
+        if (m_pid <= 0) return;
+        kill(m_pid, SIGTERM);
+        waitpid(m_pid, nullptr, 0);
+    }
+    ChildProcess(const ChildProcess&)            = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+    // Blocks until the child exits
+    void Wait() {
+        waitpid(m_pid, nullptr, 0);
+        m_pid = -1;
+    }
+
+   private:
+    pid_t m_pid;
+};
+
+// Appends up to 64 KiB of what `fd` has to `out`; returns false at EOF.
+// Callers wait on the loop between calls, so reading a large regular file,
+// which is always ready, still lets the other tasks run.
+bool Drain(int fd, std::string& out) {
+    char    buffer[65536];
+    ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (count > 0) {
+        out.append(buffer, static_cast<std::size_t>(count));
+        return true;
+    }
+    return count < 0 && (errno == EAGAIN || errno == EINTR);
+}
+
+AsyncTask RunTimeout(EventLoop& loop, Interpreter& interpreter,
+                     PopLObject callback, std::chrono::milliseconds delay) {
+    co_await loop.Sleep(delay);
+    interpreter.CallBack("setTimeout", callback.asCallable(), {});
+}
+
+AsyncTask ReadFileAsync(EventLoop& loop, Interpreter& interpreter,
+                        PopLObject callback, int fd) {
+    FileDescriptor file{fd};
+    std::string    contents;
+    do {
+        co_await loop.Readable(file.Get());
+    } while (Drain(file.Get(), contents));
+    PopLObject result{std::move(contents)};
+    interpreter.CallBack("readFileAsync", callback.asCallable(), {&result, 1});
+}
+
+AsyncTask ExecAsync(EventLoop& loop, Interpreter& interpreter,
+                    PopLObject callback, int output_fd, pid_t pid) {
+    ChildProcess child{pid};
+    std::string  output;
+    {
+        FileDescriptor pipe{output_fd};
+        do {
+            co_await loop.Readable(pipe.Get());
+        } while (Drain(pipe.Get(), output));
+    }
+    child.Wait();  // its stdout is closed, so it is exiting
+    PopLObject result{std::move(output)};
+    interpreter.CallBack("execAsync", callback.asCallable(), {&result, 1});
+}
+
+// Whether stdin's buffer holds input that waiting on fd 0 would not see.
+// std::cin is synced with stdio, so its input sits in stdin's buffer, which
+// glibc lays out in FILE (gnulib's freadahead() reads it the same way).
+// Elsewhere, assume it does and read without waiting, blocking the loop.
+bool StdinBuffered() {
+#if defined(__GLIBC__)
+    return stdin->_IO_read_ptr < stdin->_IO_read_end;
+#else
+    return true;
+#endif
+}
+
+// Reads through std::cin, as input() and the REPL do; a reader of its own
+// would take input they are owed. The loop waits for fd 0 only while stdin
+// has nothing buffered; a line that arrives in parts still blocks it until
+// its end.
+AsyncTask InputAsync(EventLoop& loop, Interpreter& interpreter,
+                     PopLObject callback) {
+    co_await loop.Yield();
+    interpreter.GetOutput().Flush();
+    if (!StdinBuffered()) co_await loop.Readable(STDIN_FILENO);
+    std::string line;
+    PopLObject  value{NilValue{}};
+    if (std::getline(std::cin, line)) value = PopLObject{std::move(line)};
+    interpreter.CallBack("inputAsync", callback.asCallable(), {&value, 1});
+}
+}  // namespace
+
+// Natives registered as pure must not change any state the script can see
+// and must return the same value for the same arguments; LoopInvariants may
+// then evaluate one call in place of many. Natives returning a new mutable
+// object are not pure, as each call's object must be distinct.
+constexpr bool kPure = true;
+
+static void Register(Interpreter& interpreter, Environment* env,
+                     std::string name, int arity, NativeFunction::FnType fn,
+                     bool pure = false) {
+    Token token = MakeBuiltinToken(name);
+
+    env->Define(token, PopLObject{runtime::MakeRef<NativeFunction>(
+                           std::move(name), arity, fn, pure)});
+}
+// Typed native: arity and argument checks come from `Fn`'s signature
+template <auto Fn>
+static void Register(Interpreter& interpreter, Environment* env,
+                     std::string name, bool pure = false) {
     Token token = MakeBuiltinToken(name);
 
-    env->Define(token, PopLObject{std::make_shared<NativeFunction>(
-                           std::move(name), arity, std::move(fn))});
+    env->Define(token,
+                PopLObject{callable::MakeNative<Fn>(std::move(name), pure)});
 }
 
 void NativeRegistry::RegisterAll(Interpreter& interpreter) {
-    auto global_env = interpreter.GetGlobalEnvironment();
+    auto* global_env = interpreter.GetGlobalEnvironment().get();
 
     // clock()
-    Register(interpreter, global_env, "clock", 0,
-             [](Interpreter&, const std::vector<PopLObject>&) -> PopLObject {
-                 using namespace std::chrono;
-                 auto   now     = system_clock::now().time_since_epoch();
-                 double seconds = duration<double>(now).count();
-                 return PopLObject(seconds);
-             });
+    Register<&Clock>(interpreter, global_env, "clock");
     // print(expression)
+    Register<&Print>(interpreter, global_env, "print");
+    // flush(): writes out everything printed so far. Output is line buffered
+    // on a terminal and block buffered otherwise, and always flushed when a
+    // run ends or reports a runtime error.
+    Register<&Flush>(interpreter, global_env, "flush");
+    // Input()
+    Register<&Input>(interpreter, global_env, "input");
+    // sqrt(x), floor(x), abs(x), pow(base, exponent)
+    Register<&Sqrt>(interpreter, global_env, "sqrt", kPure);
+    Register<&Floor>(interpreter, global_env, "floor", kPure);
+    Register<&Abs>(interpreter, global_env, "abs", kPure);
+    Register<&Pow>(interpreter, global_env, "pow", kPure);
+
+    // Files are addressed by numeric ids. openFile(path, mode) takes "r", "w"
+    // or "a"; readLine(file) and readChunk(file, size) return nil at the end
+    // of the file. write(file, text) and writeLine(file, text) are buffered
+    // until closeFile() or the end of the run. Opening files is off by
+    // default; with --allow-files any path the host user can reach is open
+    // to the script.
+    Register<&OpenFile>(interpreter, global_env, "openFile");
+    Register<&ReadLine>(interpreter, global_env, "readLine");
+    Register<&ReadChunk>(interpreter, global_env, "readChunk");
+    Register<&Write>(interpreter, global_env, "write");
+    Register<&WriteLine>(interpreter, global_env, "writeLine");
+    Register<&CloseFile>(interpreter, global_env, "closeFile");
+    // readFile(path) -> the whole file as a string
+    Register<&ReadFile>(interpreter, global_env, "readFile");
+
+    // Workers run a function in their own interpreter on a pool thread.
+    // Values are deep-copied between interpreters; a worker starts with a
+    // snapshot of the globals at spawn() time.
+    // spawn(function, argument) -> worker id
+    Register(
+        interpreter, global_env, "spawn", 2,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            if (!args[0].isCallable() || args[0].asCallable()->GetArity() != 1)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("spawn"),
+                    "spawn() expects a function taking one argument.");
+            auto id = interpreter.GetWorkerGroup().Spawn(interpreter, args[0],
+                                                         args[1]);
+            if (!id)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("spawn"),
+                    "spawn() failed: too many workers are running.");
+            return PopLObject(static_cast<double>(*id));
+        });
+    // join(worker) -> the worker function's return value
+    Register(
+        interpreter, global_env, "join", 1,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            auto id     = ToId("join", args[0]);
+            auto result = interpreter.GetWorkerGroup().Join(id);
+            if (!result)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("join"),
+                    std::format("Unknown or already joined worker {}.", id));
+            if (!result->has_value())
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("join"),
+                    std::format("Worker {} failed: {}", id, result->error()));
+            return runtime::Attach(interpreter, **result).front();
+        });
+    // channel(capacity) -> channel id
+    Register(
+        interpreter, global_env, "channel", 1,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            auto capacity = ToId("channel", args[0]);
+            auto id       = interpreter.GetWorkerGroup().NewChannel(capacity);
+            return PopLObject(static_cast<double>(id));
+        });
+    // send(channel, value), blocks while the channel is full
     Register(
-        interpreter, global_env, "print", 1,
-        [](Interpreter&, const std::vector<PopLObject>& args) -> PopLObject {
-            std::println("{}", args[0].toString());
+        interpreter, global_env, "send", 2,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            auto channel = GetChannel(interpreter, "send", args[0]);
+            if (!channel->Send(runtime::Detach(interpreter, {args[1]})))
+                throw runtime::RunTimeError(MakeBuiltinToken("send"),
+                                            "send() on a closed channel.");
             return PopLObject{NilValue{}};
         });
-    // Input()
+    // receive(channel) -> next value, or nil once the channel is closed and
+    // empty
+    Register(
+        interpreter, global_env, "receive", 1,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            auto value = GetChannel(interpreter, "receive", args[0])->Receive();
+            if (!value) return PopLObject{NilValue{}};
+            return runtime::Attach(interpreter, *value).front();
+        });
+    // close(channel)
+    Register(
+        interpreter, global_env, "close", 1,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            GetChannel(interpreter, "close", args[0])->Close();
+            return PopLObject{NilValue{}};
+        });
+
+    // range(n) -> [0, 1, ..., n - 1]
+    Register(
+        interpreter, global_env, "range", 1,
+        [](Interpreter&, std::span<const PopLObject> args) -> PopLObject {
+            if (!args[0].isNumber() || args[0].asNumber() < 0)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("range"),
+                    "range() expects a non-negative number.");
+            auto count = static_cast<std::size_t>(args[0].asNumber());
+            std::vector<PopLObject> elements;
+            elements.reserve(count);
+            for (std::size_t i = 0; i < count; ++i)
+                elements.emplace_back(static_cast<double>(i));
+            return PopLObject{
+                std::make_shared<runtime::PoplArray>(std::move(elements))};
+        });
+    // len(array, map, Float64Array or string)
+    Register(
+        interpreter, global_env, "len", 1,
+        [](Interpreter&, std::span<const PopLObject> args) -> PopLObject {
+            std::size_t length = 0;
+            if (args[0].isArray())
+                length = args[0].asArray()->Size();
+            else if (args[0].isMap())
+                length = args[0].asMap()->Size();
+            else if (args[0].isFloat64Array())
+                length = args[0].asFloat64Array()->Size();
+            else if (args[0].isString())
+                length = args[0].asStringPtr()->Size();
+            else
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("len"),
+                    "len() expects an array, a map or a string.");
+            return PopLObject(static_cast<double>(length));
+        },
+        kPure);
+    // joinStrings(array, separator) -> the elements as one string
+    Register<&Join>(interpreter, global_env, "joinStrings", kPure);
+    // push(array, value) -> new length
+    Register<&Push>(interpreter, global_env, "push");
+    // pop(array) -> removed last element
+    Register<&Pop>(interpreter, global_env, "pop");
+    // slice(array, begin, end) -> copy of array[begin..end)
+    Register<&Slice>(interpreter, global_env, "slice");
+    // sort(array) -> array, sorted in place; all numbers or all strings
+    Register<&Sort>(interpreter, global_env, "sort");
+    // map(array, fn) -> [fn(array[0]), ...]
+    Register<&Map>(interpreter, global_env, "map");
+    // filter(array, fn) -> elements for which fn(element) is truthy
+    Register<&Filter>(interpreter, global_env, "filter");
+    // has(map, key)
+    Register<&Has>(interpreter, global_env, "has", kPure);
+    // get(map, key) -> value, or nil when the key is absent
+    Register<&Get>(interpreter, global_env, "get", kPure);
+    // set(map, key, value) -> value
+    Register<&Set>(interpreter, global_env, "set");
+    // delete(map, key) -> whether the key was present
+    Register<&Delete>(interpreter, global_env, "delete");
+    // keys(map), values(map), entries(map) -> arrays in unspecified order;
+    // entries are [key, value] pairs
+    Register<&Keys>(interpreter, global_env, "keys");
+    Register<&Values>(interpreter, global_env, "values");
+    Register<&Entries>(interpreter, global_env, "entries");
+
+    // Float64Array natives run over raw doubles with the widest vector
+    // kernels the CPU supports.
+    // float64Array(length or array of numbers)
+    Register(
+        interpreter, global_env, "float64Array", 1,
+        [](Interpreter&                interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            if (args[0].isNumber()) {
+                std::size_t length = ToLength("float64Array", args[0]);
+                interpreter.CheckAlloc(runtime::Float64Array::Bytes(length));
+                try {
+                    return PopLObject{
+                        std::make_shared<runtime::Float64Array>(length)};
+                } catch (const std::bad_alloc&) {
+                    throw runtime::RunTimeError(
+                        MakeBuiltinToken("float64Array"),
+                        std::format("Out of memory for {} elements.", length));
+                }
+            }
+            if (!args[0].isArray())
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("float64Array"),
+                    "float64Array() expects a length or an array.");
+            const auto&         elements = args[0].asArray()->GetElements();
+            std::vector<double> data;
+            data.reserve(elements.size());
+            for (const auto& element : elements) {
+                if (!element.isNumber())
+                    throw runtime::RunTimeError(
+                        MakeBuiltinToken("float64Array"),
+                        std::format("float64Array() got non-number '{}'.",
+                                    element.toString()));
+                data.push_back(element.asNumber());
+            }
+            return PopLObject{
+                std::make_shared<runtime::Float64Array>(std::move(data))};
+        });
+    // toArray(float64Array) -> plain array
+    Register<&ToArray>(interpreter, global_env, "toArray");
+    // sum(x), dot(x, y)
+    Register<&Sum>(interpreter, global_env, "sum", kPure);
+    Register<&Dot>(interpreter, global_env, "dot", kPure);
+    // axpy(alpha, x, y) -> y, after y = alpha * x + y in place
+    Register<&Axpy>(interpreter, global_env, "axpy");
+    // vecAdd(x, y), vecMul(x, y) -> new arrays of elementwise results
+    Register<&VecAdd>(interpreter, global_env, "vecAdd");
+    Register<&VecMul>(interpreter, global_env, "vecMul");
+    // vecMin(x), vecMax(x) -> smallest and largest element, nil when empty
+    Register<&VecMin>(interpreter, global_env, "vecMin", kPure);
+    Register<&VecMax>(interpreter, global_env, "vecMax", kPure);
+    // prefixSum(x) -> running totals as a new array
+    Register<&PrefixSum>(interpreter, global_env, "prefixSum");
+
+
+    // parallelMap(array, fn) -> [fn(array[0]), ...] computed on all cores
     Register(
-        interpreter, global_env, "input", 0,
-        [](Interpreter&, const std::vector<PopLObject>& args) -> PopLObject {
-            std::string line;
-            std::getline(std::cin, line);
-            return PopLObject(std::move(line));
+        interpreter, global_env, "parallelMap", 2,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            if (!args[0].isArray() || !args[1].isCallable() ||
+                args[1].asCallable()->GetArity() != 1)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("parallelMap"),
+                    "parallelMap() expects an array and a function taking "
+                    "one argument.");
+            return PopLObject{
+                runtime::ParallelMap(interpreter, args[0].asArray(), args[1])};
+        });
+    // parallelReduce(array, fn, init), fn(accumulator, item) must be
+    // associative
+    Register(
+        interpreter, global_env, "parallelReduce", 3,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            if (!args[0].isArray() || !args[1].isCallable() ||
+                args[1].asCallable()->GetArity() != 2)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("parallelReduce"),
+                    "parallelReduce() expects an array and a function taking "
+                    "two arguments.");
+            return runtime::ParallelReduce(interpreter, args[0].asArray(),
+                                           args[1], args[2]);
+        });
+
+    // setTimeout(fn, ms), calls fn() after ms milliseconds
+    Register(
+        interpreter, global_env, "setTimeout", 2,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            CheckCallback("setTimeout", args[0], 0);
+            if (!args[1].isNumber() || !std::isfinite(args[1].asNumber()) ||
+                args[1].asNumber() < 0)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("setTimeout"),
+                    "setTimeout() expects a finite, non-negative delay.");
+            // Longer delays wait the longest timeout a browser allows
+            constexpr double kMaxDelayMs = 2147483647.0;
+            std::chrono::duration<double, std::milli> delay{
+                std::min(args[1].asNumber(), kMaxDelayMs)};
+            RunTimeout(interpreter.GetEventLoop(), interpreter, args[0],
+                       std::chrono::duration_cast<std::chrono::milliseconds>(
+                           delay));
+            return PopLObject{NilValue{}};
+        });
+    // readFileAsync(path, fn), calls fn(contents)
+    Register(
+        interpreter, global_env, "readFileAsync", 2,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            CheckAllowed("readFileAsync", interpreter.GetLimits().allow_files,
+                         "--allow-files");
+            CheckCallback("readFileAsync", args[1], 1);
+            std::string path = args[0].toString();
+            int         fd   = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+            if (fd < 0)
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("readFileAsync"),
+                    std::format("Failed to open '{}'.", path));
+            ReadFileAsync(interpreter.GetEventLoop(), interpreter, args[1], fd);
+            return PopLObject{NilValue{}};
+        });
+    // execAsync(command, fn), runs command with /bin/sh and calls fn(stdout).
+    // Only with --allow-exec: the command is not escaped in any way.
+    Register(
+        interpreter, global_env, "execAsync", 2,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            CheckAllowed("execAsync", interpreter.GetLimits().allow_exec,
+                         "--allow-exec");
+            CheckCallback("execAsync", args[1], 1);
+            std::string command = args[0].toString();
+            int         fds[2];
+            if (pipe2(fds, O_CLOEXEC) != 0)
+                throw runtime::RunTimeError(MakeBuiltinToken("execAsync"),
+                                            "Failed to create a pipe.");
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+            const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+            pid_t       pid    = -1;
+            int         error  = posix_spawn(&pid, "/bin/sh", &actions, nullptr,
+                                             const_cast<char**>(argv), environ);
+            posix_spawn_file_actions_destroy(&actions);
+            close(fds[1]);
+            if (error != 0) {
+                close(fds[0]);
+                throw runtime::RunTimeError(
+                    MakeBuiltinToken("execAsync"),
+                    std::format("Failed to run '{}'.", command));
+            }
+            fcntl(fds[0], F_SETFL, O_NONBLOCK);
+            ExecAsync(interpreter.GetEventLoop(), interpreter, args[1], fds[0],
+                      pid);
+            return PopLObject{NilValue{}};
+        });
+    // inputAsync(fn), calls fn(line) with the next line of stdin, or fn(nil)
+    // at EOF, from the event loop. Reading blocks the loop.
+    Register(
+        interpreter, global_env, "inputAsync", 1,
+        [](Interpreter& interpreter,
+           std::span<const PopLObject> args) -> PopLObject {
+            CheckCallback("inputAsync", args[0], 1);
+            InputAsync(interpreter.GetEventLoop(), interpreter, args[0]);
+            return PopLObject{NilValue{}};
         });
 }
 
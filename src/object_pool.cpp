@@ -0,0 +1,39 @@
+#include "popl/runtime/object_pool.hpp"
+
+#include <cstddef>
+#include <new>
+
+namespace popl::runtime {
+
+namespace {
+// Precedes every Pooled object; null when it came from the global heap
+struct alignas(std::max_align_t) BlockHeader {
+    ObjectPool* pool;
+};
+}  // namespace
+
+void* Pooled::operator new(std::size_t size) {
+    ObjectPool* pool = t_current_pool;
+    if (pool && pool->GetStrategy() == ObjectPool::Strategy::SYSTEM)
+        pool = nullptr;
+    std::size_t total = sizeof(BlockHeader) + size;
+    void*       block = pool ? pool->Resource()->allocate(
+                                   total, alignof(BlockHeader))
+                             : ::operator new(total);
+    if (pool) pool->AddRef();
+    return new (block) BlockHeader{pool} + 1;
+}
+
+void Pooled::operator delete(void* ptr, std::size_t size) {
+    auto*       header = static_cast<BlockHeader*>(ptr) - 1;
+    ObjectPool* pool   = header->pool;
+    std::size_t total  = sizeof(BlockHeader) + size;
+    if (!pool) {
+        ::operator delete(header, total);
+        return;
+    }
+    pool->Resource()->deallocate(header, total, alignof(BlockHeader));
+    if (pool->Release()) delete pool;
+}
+
+}  // namespace popl::runtime
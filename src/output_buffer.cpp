@@ -0,0 +1,68 @@
+#include "popl/runtime/output_buffer.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace popl::runtime {
+
+// Writes all of `text`, retrying short and interrupted writes
+static bool WriteAll(int fd, std::string_view text) {
+    while (!text.empty()) {
+        ssize_t written = ::write(fd, text.data(), text.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        text.remove_prefix(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+OutputBuffer::OutputBuffer(int fd, Mode mode)
+    : m_fd{fd}, m_data{std::make_unique_for_overwrite<char[]>(kCapacity)} {
+    SetMode(mode);
+}
+
+OutputBuffer::~OutputBuffer() { Flush(); }
+
+void OutputBuffer::SetMode(Mode mode) {
+    if (mode == Mode::AUTO) mode = ::isatty(m_fd) ? Mode::LINE : Mode::FULL;
+    m_mode = mode;
+}
+
+void OutputBuffer::Write(std::string_view text) {
+    Append(text);
+    if (m_mode == Mode::LINE && text.find('\n') != std::string_view::npos)
+        Flush();
+}
+
+void OutputBuffer::WriteLine(std::string_view text) {
+    Append(text);
+    Append("\n");
+    if (m_mode == Mode::LINE) Flush();
+}
+
+void OutputBuffer::Append(std::string_view text) {
+    if (text.size() > kCapacity - m_size) {
+        Flush();
+        // Too large to be worth copying
+        if (text.size() >= kCapacity) {
+            WriteAll(m_fd, text);
+            return;
+        }
+    }
+    std::memcpy(m_data.get() + m_size, text.data(), text.size());
+    m_size += text.size();
+}
+
+void OutputBuffer::Flush() {
+    if (m_fd == STDOUT_FILENO) std::fflush(stdout);
+    if (m_size == 0) return;
+    WriteAll(m_fd, {m_data.get(), m_size});
+    m_size = 0;
+}
+
+}  // namespace popl::runtime
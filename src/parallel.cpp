@@ -0,0 +1,140 @@
+#include "popl/runtime/parallel.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "popl/runtime/transfer.hpp"
+#include "popl/runtime/work_stealing_pool.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
+
+namespace popl::runtime {
+
+namespace {
+using Indexed = std::vector<std::pair<std::size_t, PopLObject>>;
+
+// One interpreter per participant of a ParallelFor, created lazily on the
+// participant's own thread
+class ParallelContexts {
+   public:
+    struct Context {
+        std::unique_ptr<Interpreter> interpreter;
+        std::unique_ptr<Attacher>    attacher;
+        std::optional<PopLObject>    fn;
+        Indexed                      results;
+    };
+
+    ParallelContexts(Interpreter& caller, const PopLObject& fn,
+                     const std::shared_ptr<PoplArray>& items)
+        : m_graph{Detach(caller, {fn, PopLObject{items}},
+                         /*with_globals=*/true)},
+          m_items{m_graph.values[1].asArray()},
+          m_meter{caller.GetMeter()},
+          m_contexts(WorkStealingPool::Shared().Concurrency()) {
+        // Participants buffer their own output; keep the caller's first
+        caller.GetOutput().Flush();
+    }
+
+    Context& Get(unsigned participant) {
+        auto& context = m_contexts[participant];
+        if (!context.interpreter) {
+            context.interpreter = std::make_unique<Interpreter>();
+            context.interpreter->InheritBudget(m_meter);
+            context.attacher =
+                std::make_unique<Attacher>(*context.interpreter, m_graph);
+            context.fn = context.attacher->Copy(m_graph.values[0]);
+        }
+        return context;
+    }
+
+    PopLObject Item(Context& context, std::size_t index) const {
+        return context.attacher->Copy(m_items->GetElements()[index]);
+    }
+
+    PopLObject Call(Context& context, std::span<const PopLObject> args) {
+        return context.interpreter->CallFunction(*context.fn, args);
+    }
+
+    // Copies every participant's results into `caller`
+    Indexed Collect(Interpreter& caller) {
+        Indexed collected;
+        for (auto& context : m_contexts) {
+            if (!context.interpreter) continue;
+            std::vector<PopLObject> values;
+            values.reserve(context.results.size());
+            for (auto& [_, value] : context.results) values.push_back(value);
+            values = Transfer(*context.interpreter, caller, values);
+            for (std::size_t i = 0; i < values.size(); ++i)
+                collected.emplace_back(context.results[i].first,
+                                       std::move(values[i]));
+        }
+        return collected;
+    }
+
+   private:
+    DetachedGraph              m_graph;
+    std::shared_ptr<PoplArray> m_items;
+    ResourceMeter              m_meter;
+    std::vector<Context>       m_contexts;
+};
+
+// Several chunks per participant so that stealing can even out the load
+std::size_t GrainFor(std::size_t count) {
+    auto participants = WorkStealingPool::Shared().Concurrency();
+    return std::max<std::size_t>(1, count / (participants * 8));
+}
+}  // namespace
+
+std::shared_ptr<PoplArray> ParallelMap(Interpreter&                      caller,
+                                       const std::shared_ptr<PoplArray>& items,
+                                       const PopLObject&                 fn) {
+    std::size_t      count = items->Size();
+    ParallelContexts contexts{caller, fn, items};
+    WorkStealingPool::Shared().ParallelFor(
+        count, GrainFor(count),
+        [&](unsigned participant, std::size_t begin, std::size_t end) {
+            auto& context = contexts.Get(participant);
+            for (std::size_t i = begin; i < end; ++i) {
+                PopLObject item[] = {contexts.Item(context, i)};
+                context.results.emplace_back(i, contexts.Call(context, item));
+            }
+        });
+
+    std::vector<PopLObject> results(count, PopLObject{NilValue{}});
+    for (auto& [index, value] : contexts.Collect(caller))
+        results[index] = std::move(value);
+    return std::make_shared<PoplArray>(std::move(results));
+}
+
+PopLObject ParallelReduce(Interpreter&                      caller,
+                          const std::shared_ptr<PoplArray>& items,
+                          const PopLObject& fn, const PopLObject& init) {
+    std::size_t      count = items->Size();
+    ParallelContexts contexts{caller, fn, items};
+    WorkStealingPool::Shared().ParallelFor(
+        count, GrainFor(count),
+        [&](unsigned participant, std::size_t begin, std::size_t end) {
+            auto& context = contexts.Get(participant);
+            auto  partial = contexts.Item(context, begin);
+            for (std::size_t i = begin + 1; i < end; ++i) {
+                PopLObject args[] = {partial, contexts.Item(context, i)};
+                partial           = contexts.Call(context, args);
+            }
+            context.results.emplace_back(begin, std::move(partial));
+        });
+
+    auto partials = contexts.Collect(caller);
+    std::sort(partials.begin(), partials.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    PopLObject accumulator = init;
+    auto       callable    = fn.asCallable();
+    for (auto& [_, partial] : partials) {
+        PopLObject args[] = {accumulator, partial};
+        accumulator = caller.CallBack("parallelReduce", callable, args);
+    }
+    return accumulator;
+}
+
+}  // namespace popl::runtime
@@ -243,8 +243,13 @@ Expr Parser::Assignment() {
             GetExpr gexp{std::move(std::get<GetExpr>(expr.node))};
             return Expr{SetExpr{std::move(gexp.object), gexp.name,
                                 MakeExprPtr(std::move(value))}};
+        } else if (std::holds_alternative<IndexExpr>(expr.node)) {
+            IndexExpr iexp{std::move(std::get<IndexExpr>(expr.node))};
+            return Expr{IndexSetExpr{std::move(iexp.object), iexp.bracket,
+                                     std::move(iexp.index),
+                                     MakeExprPtr(std::move(value))}};
         }
-        Diagnostics::Error(equal, "Invalid assignment target.");
+        m_diagnostics.Error(equal, "Invalid assignment target.");
     }
     return expr;
 }
@@ -304,6 +309,15 @@ Expr Parser::CallExpression() {
             Expr  object = std::move(expr);
             expr.node.emplace<GetExpr>(MakeExprPtr(std::move(object)), name);
 
+        } else if (Match({TokenType::LEFT_BRACKET})) {
+            Token bracket = Previous();
+            Expr  index   = Expression();
+            Consume(TokenType::RIGHT_BRACKET, "Expect ']' after index.");
+            Expr object = std::move(expr);
+            expr.node.emplace<IndexExpr>(MakeExprPtr(std::move(object)),
+                                         bracket,
+                                         MakeExprPtr(std::move(index)));
+
         } else {
             break;
         }
@@ -338,6 +352,8 @@ Expr Parser::Primary() {
         return Expr{VariableExpr{Previous()}};
     }
     if (Match({TokenType::FUN})) return AnonymousFunction();
+    if (Match({TokenType::LEFT_BRACKET})) return ArrayLiteral();
+    if (Match({TokenType::LEFT_BRACE})) return MapLiteral();
     if (Match({TokenType::LEFT_PAREN})) {
         Expr expr{Expression()};
         Consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
@@ -363,4 +379,31 @@ Expr Parser::AnonymousFunction() {
 
     return Expr{FunctionExpr{std::move(parameters), std::move(body)}};
 }
+Expr Parser::ArrayLiteral() {
+    Token                              bracket = Previous();
+    std::vector<std::unique_ptr<Expr>> elements;
+    if (!Check(TokenType::RIGHT_BRACKET)) {
+        do {
+            elements.emplace_back(MakeExprPtr(ArgumentExpression()));
+        } while (Match({TokenType::COMMA}));
+    }
+    Consume(TokenType::RIGHT_BRACKET, "Expect ']' after array elements.");
+    return Expr{ArrayExpr{std::move(bracket), std::move(elements)}};
+}
+// A '{' that starts a statement is a block, so this only sees map literals
+Expr Parser::MapLiteral() {
+    Token                              brace = Previous();
+    std::vector<std::unique_ptr<Expr>> keys;
+    std::vector<std::unique_ptr<Expr>> values;
+    if (!Check(TokenType::RIGHT_BRACE)) {
+        do {
+            keys.emplace_back(MakeExprPtr(ArgumentExpression()));
+            Consume(TokenType::COLON, "Expect ':' after map key.");
+            values.emplace_back(MakeExprPtr(ArgumentExpression()));
+        } while (Match({TokenType::COMMA}));
+    }
+    Consume(TokenType::RIGHT_BRACE, "Expect '}' after map entries.");
+    return Expr{
+        MapExpr{std::move(brace), std::move(keys), std::move(values)}};
+}
 };  // namespace popl
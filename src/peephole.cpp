@@ -0,0 +1,180 @@
+#include "popl/syntax/visitors/peephole.hpp"
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "popl/lexer/token_types.hpp"
+#include "popl/syntax/ast/expr.hpp"
+#include "popl/syntax/ast/stmt.hpp"
+
+namespace popl {
+
+namespace {
+bool IsOrdering(TokenType type) {
+    return type == TokenType::LESS || type == TokenType::LESS_EQUAL ||
+           type == TokenType::GREATER || type == TokenType::GREATER_EQUAL;
+}
+
+// The number `expr` is a literal of, if any
+std::optional<double> NumberLiteral(const Expr& expr) {
+    auto* literal = std::get_if<LiteralExpr>(&expr.node);
+    if (!literal || !literal->value.isNumber()) return std::nullopt;
+    return literal->value.asNumber();
+}
+}  // namespace
+
+void Peephole::Optimize(std::vector<std::unique_ptr<Stmt>>& statements) {
+    for (auto& stmt : statements)
+        if (stmt) Optimize(*stmt);
+}
+void Peephole::Optimize(Stmt& stmt) {
+    visitStmtWithArgs(
+        stmt,
+        [this](auto&& contained, Stmt& originalStmt) {
+            return (*this)(contained, originalStmt);
+        },
+        stmt);
+}
+void Peephole::Optimize(Expr& expr) {
+    visitExprWithArgs(
+        expr,
+        [this](auto&& contained, Expr& originalExpr) {
+            return (*this)(contained, originalExpr);
+        },
+        expr);
+}
+
+/*
+ * Statements
+ */
+void Peephole::operator()(ExpressionStmt& stmt, Stmt&) {
+    Optimize(*stmt.expression);
+}
+void Peephole::operator()(NilStmt&, Stmt&) {}
+void Peephole::operator()(VarStmt& stmt, Stmt&) {
+    if (stmt.initializer) Optimize(*stmt.initializer);
+}
+void Peephole::operator()(BlockStmt& stmt, Stmt&) { Optimize(stmt.statements); }
+void Peephole::operator()(IfStmt& stmt, Stmt&) {
+    Optimize(*stmt.condition);
+    Optimize(*stmt.thenBranch);
+    if (stmt.elseBranch) Optimize(*stmt.elseBranch);
+}
+void Peephole::operator()(WhileStmt& stmt, Stmt&) {
+    Optimize(*stmt.condition);
+    Optimize(*stmt.body);
+}
+void Peephole::operator()(BreakStmt&, Stmt&) {}
+void Peephole::operator()(ContinueStmt&, Stmt&) {}
+void Peephole::operator()(ReturnStmt& stmt, Stmt&) {
+    if (stmt.value) Optimize(*stmt.value);
+}
+void Peephole::operator()(FunctionStmt& stmt, Stmt&) {
+    Optimize(stmt.func->body);
+}
+void Peephole::operator()(ClassStmt& stmt, Stmt&) {
+    for (auto& method : stmt.methods) Optimize(method->func->body);
+}
+
+/*
+ * Expressions
+ */
+void Peephole::operator()(LiteralExpr&, Expr&) {}
+void Peephole::operator()(GroupingExpr& expr, Expr&) {
+    Optimize(*expr.expression);
+}
+void Peephole::operator()(TernaryExpr& expr, Expr&) {
+    Optimize(*expr.condition);
+    Optimize(*expr.thenBranch);
+    Optimize(*expr.elseBranch);
+}
+void Peephole::operator()(UnaryExpr& expr, Expr&) { Optimize(*expr.right); }
+void Peephole::operator()(BinaryExpr& expr, Expr& originalExpr) {
+    Optimize(*expr.left);
+    Optimize(*expr.right);
+
+    auto* left = std::get_if<VariableExpr>(&expr.left->node);
+    if (!left || !IsOrdering(expr.op.GetType())) return;
+    auto* right    = std::get_if<VariableExpr>(&expr.right->node);
+    auto  constant = NumberLiteral(*expr.right);
+    if (!right && !constant) return;
+    CompareExpr fused{.left     = std::move(*left),
+                      .op       = expr.op,
+                      .constant = constant.value_or(0.0)};
+    if (right) fused.right = std::move(*right);
+    originalExpr.node = std::move(fused);
+}
+void Peephole::operator()(VariableExpr&, Expr&) {}
+void Peephole::operator()(NilExpr&, Expr&) {}
+void Peephole::operator()(LogicalExpr& expr, Expr&) {
+    Optimize(*expr.left);
+    Optimize(*expr.right);
+}
+void Peephole::operator()(CallExpr& expr, Expr&) {
+    Optimize(*expr.callee);
+    for (auto& arg : expr.arguments) Optimize(*arg);
+}
+void Peephole::operator()(AssignExpr& expr, Expr& originalExpr) {
+    Optimize(*expr.value);
+
+    auto* binary = std::get_if<BinaryExpr>(&expr.value->node);
+    if (!binary || (binary->op.GetType() != TokenType::PLUS &&
+                    binary->op.GetType() != TokenType::MINUS))
+        return;
+    auto* read     = std::get_if<VariableExpr>(&binary->left->node);
+    auto  constant = NumberLiteral(*binary->right);
+    // Both sides must resolve to the same variable
+    if (!read || !constant ||
+        read->name.GetLexeme() != expr.name.GetLexeme() ||
+        read->depth != expr.depth || read->upvalue != expr.upvalue)
+        return;
+    IncrementExpr fused{.name     = expr.name,
+                        .op       = binary->op,
+                        .constant = *constant,
+                        .depth    = expr.depth,
+                        .upvalue  = expr.upvalue};
+    originalExpr.node = std::move(fused);
+}
+void Peephole::operator()(FunctionExpr& expr, Expr&) { Optimize(expr.body); }
+void Peephole::operator()(GetExpr& expr, Expr& originalExpr) {
+    Optimize(*expr.object);
+
+    auto* object = std::get_if<ThisExpr>(&expr.object->node);
+    if (!object) return;
+    ThisGetExpr fused{.object = std::move(*object), .name = expr.name};
+    originalExpr.node = std::move(fused);
+}
+void Peephole::operator()(SetExpr& expr, Expr&) {
+    Optimize(*expr.object);
+    Optimize(*expr.value);
+}
+void Peephole::operator()(ThisExpr&, Expr&) {}
+void Peephole::operator()(ArrayExpr& expr, Expr&) {
+    for (auto& element : expr.elements) Optimize(*element);
+}
+void Peephole::operator()(IndexExpr& expr, Expr&) {
+    Optimize(*expr.object);
+    Optimize(*expr.index);
+}
+void Peephole::operator()(IndexSetExpr& expr, Expr&) {
+    Optimize(*expr.object);
+    Optimize(*expr.index);
+    Optimize(*expr.value);
+}
+void Peephole::operator()(MapExpr& expr, Expr&) {
+    for (std::size_t i = 0; i < expr.keys.size(); ++i) {
+        Optimize(*expr.keys[i]);
+        Optimize(*expr.values[i]);
+    }
+}
+// Nothing left to fuse
+void Peephole::operator()(IncrementExpr&, Expr&) {}
+void Peephole::operator()(CompareExpr&, Expr&) {}
+void Peephole::operator()(ThisGetExpr&, Expr&) {}
+void Peephole::operator()(InvariantExpr& expr, Expr&) {
+    Optimize(*expr.expression);
+}
+
+}  // namespace popl
@@ -0,0 +1,36 @@
+#include "popl/runtime/popl_array.hpp"
+
+#include <algorithm>
+
+#include "popl/literal.hpp"
+#include "popl/runtime/print_guard.hpp"
+
+namespace popl::runtime {
+
+PoplArray::PoplArray() { ChargeAlloc(sizeof(PoplArray)); }
+PoplArray::PoplArray(std::vector<popl::PopLObject> elements)
+    : m_elements(std::move(elements)) {
+    ChargeAlloc(sizeof(PoplArray) + m_elements.size() * sizeof(PopLObject));
+}
+PoplArray::~PoplArray() = default;
+
+std::size_t PoplArray::Size() const { return m_elements.size(); }
+
+void PoplArray::Push(popl::PopLObject value) {
+    if (m_elements.size() == m_elements.capacity())
+        ChargeAlloc(std::max<std::size_t>(m_elements.size(), 1) *
+                    sizeof(PopLObject));
+    m_elements.push_back(std::move(value));
+}
+
+std::string PoplArray::ToString() const {
+    PrintGuard guard{this};
+    if (!guard.Entered()) return "[...]";
+    std::string out{"["};
+    for (std::size_t i = 0; i < m_elements.size(); ++i) {
+        if (i) out += ", ";
+        out += m_elements[i].toString();
+    }
+    return out + "]";
+}
+};  // namespace popl::runtime
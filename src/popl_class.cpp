@@ -4,26 +4,31 @@
 
 #include "popl/literal.hpp"
 #include "popl/runtime/popl_instance.hpp"
+#include "popl/runtime/tracer.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
 
 namespace popl {
 namespace runtime {
-popl::PopLObject PoplClass::Call(popl::Interpreter& interpreter,
-                                 const std::vector<popl::PopLObject>& args) {
-    auto instance = std::make_shared<PoplInstance>(shared_from_this());
-
-    auto initializer = GetMethod("init");
-    if (initializer) {
-        initializer.value()->Bind(instance)->Call(interpreter, args);
+PoplClass::PoplClass(
+    std::string                                                  name,
+    std::unordered_map<std::string, Ref<callable::PoplFunction>> methods)
+    : m_name(std::move(name)), m_methods(std::move(methods)) {
+    if (auto it = m_methods.find("init"); it != m_methods.end()) {
+        m_initializer = it->second;
+        m_arity       = m_initializer->GetArity();
     }
-    return popl::PopLObject{instance};
 }
 
-int PoplClass::GetArity() const {
-    auto initializer{GetMethod("init")};
-    if (!initializer) return 0;
-    return initializer.value()->GetArity();
+popl::PopLObject PoplClass::Call(popl::Interpreter&                interpreter,
+                                 std::span<const popl::PopLObject> args) {
+    TraceScope trace{interpreter.GetTracer(), m_name, TraceCategory::POPL_CALL};
+
+    auto instance = MakeRef<PoplInstance>(Ref<PoplClass>(this));
+    if (m_initializer) m_initializer->Construct(interpreter, args, instance);
+    return popl::PopLObject{std::move(instance)};
 }
-std::optional<std::shared_ptr<popl::callable::PoplFunction>>
+
+std::optional<Ref<popl::callable::PoplFunction>>
 PoplClass::GetMethod(const std::string& name) const {
     auto it = m_methods.find(name);
     if (it == m_methods.end()) return std::nullopt;
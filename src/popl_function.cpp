@@ -1,39 +1,69 @@
 #include "popl/callables/popl_function.hpp"
 
-#include <memory>
-
 #include "popl/environment.hpp"
 #include "popl/lexer/token_types.hpp"
 #include "popl/literal.hpp"
 #include "popl/runtime/control_flow.hpp"
+#include "popl/runtime/stats.hpp"
+#include "popl/runtime/tracer.hpp"
 #include "popl/syntax/visitors/interpreter.hpp"
 
 namespace popl::callable {
-PopLObject PoplFunction::Call(Interpreter&                   interpreter,
-                              const std::vector<PopLObject>& args) {
-    auto localEnv{std::make_shared<Environment>(m_closure)};
-    for (size_t i = 0; i < m_declaration->params.size(); ++i) {
-        localEnv->Define(m_declaration->params[i], args[i]);
-    }
-    if (m_isInitializer) {
+PopLObject PoplFunction::Call(Interpreter&                interpreter,
+                              std::span<const PopLObject> args) {
+    PopLObject result = Invoke(interpreter, args, m_closure);
+    // A bound initializer returns its instance
+    if (m_isInitializer)
         return m_closure->GetAt(
             0, Token{TokenType::THIS, "this", PopLObject{NilValue{}}, 0});
+    return result;
+}
+
+void PoplFunction::Construct(Interpreter&                        interpreter,
+                             std::span<const PopLObject>         args,
+                             runtime::Ref<runtime::PoplInstance> instance) {
+    // The environment Bind() would create; closures capture `this` into a
+    // cell, so it can live on the stack. It is counted on its own: Invoke()
+    // puts the parameters in a second one on top of it, as for a bound call.
+    POPL_STATS_INC(stack_environments);
+    runtime::ScopedRef<Environment> thisEnv{m_closure};
+    thisEnv->Define("this", PopLObject{std::move(instance)});
+    Invoke(interpreter, args, thisEnv.Get());
+}
+
+PopLObject PoplFunction::Invoke(Interpreter&                interpreter,
+                                std::span<const PopLObject> args,
+                                runtime::Ref<Environment>   closure) {
+    runtime::TraceScope trace{
+        interpreter.GetTracer(),
+        m_name ? std::string_view{*m_name} : std::string_view{"<anonymous>"},
+        runtime::TraceCategory::POPL_CALL};
+
+    // Closures capture cells, never the environment, so nothing can keep it
+    // alive after the call returns
+    POPL_STATS_INC(stack_environments);
+    runtime::ScopedRef<Environment> localEnv{std::move(closure)};
+    for (size_t i = 0; i < m_declaration->params.size(); ++i) {
+        localEnv->Define(m_declaration->params[i], args[i]);
     }
     try {
-        interpreter.ExecuteBlock(m_declaration->body, localEnv);
-    } catch (const runtime::control_flow::ReturnSignal& returnValue) {
-        return returnValue.value;
+        interpreter.ExecuteFunction(m_declaration->body, localEnv.Get(),
+                                    m_upvalues);
+    } catch (runtime::control_flow::ReturnSignal& returnValue) {
+        return std::move(returnValue.value);
     }
     return PopLObject{NilValue{}};
 }
 
-std::shared_ptr<PoplFunction> PoplFunction::Bind(
-    std::shared_ptr<runtime::PoplInstance> instance) {
-    auto environment = std::make_shared<Environment>(m_closure);
-    environment->Define("this", PopLObject{instance});
+runtime::Ref<PoplFunction> PoplFunction::Bind(
+    runtime::Ref<runtime::PoplInstance> instance) {
+    POPL_STATS_INC(bound_methods_created);
+    auto environment = Environment::Make(m_closure);
+    environment->Define("this", PopLObject{std::move(instance)});
 
-    return std::make_shared<PoplFunction>(m_declaration, environment, m_name,
-                                          m_isInitializer);
+    return runtime::MakeRef<PoplFunction>(
+        m_declaration, environment, m_name, m_isInitializer,
+        Upvalues{m_upvalues, runtime::CurrentResource()});
 }
 std::string PoplFunction::ToString() const {
     if (m_name) {
@@ -2,11 +2,19 @@
 
 #include "popl/lexer/token.hpp"
 #include "popl/literal.hpp"
+#include "popl/runtime/object_pool.hpp"
 #include "popl/runtime/popl_class.hpp"
 #include "popl/runtime/run_time_error.hpp"
 
 namespace popl::runtime {
 
+PoplInstance::PoplInstance(Ref<PoplClass> klass)
+    : m_creator_class(std::move(klass)), m_fields(CurrentResource()) {
+    POPL_STATS_OBJECT_CREATED(instances_created);
+    ChargeAlloc(sizeof(PoplInstance));
+}
+PoplInstance::~PoplInstance() { POPL_STATS_OBJECT_DESTROYED(); }
+
 std::string PoplInstance::ToString() const {
     return "Instance of " + m_creator_class->ToString();
 }
@@ -14,11 +22,16 @@ popl::PopLObject PoplInstance::Get(const Token& name) {
     auto it = m_fields.find(name.GetLexeme());
     if (it != m_fields.end()) return it->second;
     auto method{m_creator_class->GetMethod(name.GetLexeme())};
-    if (method) return PopLObject{method.value()->Bind(shared_from_this())};
+    if (method)
+        return PopLObject{method.value()->Bind(Ref<PoplInstance>(this))};
     throw RunTimeError(name, "Undefined property '" + name.GetLexeme() + "'.");
 }
 
-void PoplInstance::Set(Token name, popl::PopLObject value) {
-    m_fields.insert_or_assign(std::move(name.GetLexeme()), std::move(value));
+// The key is only copied when the field is new
+void PoplInstance::Set(const Token& name, popl::PopLObject value) {
+    m_fields.insert_or_assign(name.GetLexeme(), std::move(value));
+}
+void PoplInstance::Set(std::string name, popl::PopLObject value) {
+    m_fields.insert_or_assign(std::move(name), std::move(value));
 }
 };  // namespace popl::runtime
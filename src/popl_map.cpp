@@ -0,0 +1,198 @@
+#include "popl/runtime/popl_map.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "popl/literal.hpp"
+#include "popl/runtime/print_guard.hpp"
+
+namespace popl::runtime {
+
+struct PoplMap::Slot {
+    std::size_t hash{0};
+    PopLObject  key{NilValue{}};
+    PopLObject  value{NilValue{}};
+};
+
+namespace {
+// Control bytes: a full slot stores the low 7 bits of its hash (sign bit
+// clear); empty and deleted slots are negative
+constexpr std::int8_t kEmpty      = -128;
+constexpr std::int8_t kDeleted    = -2;
+constexpr std::size_t kGroupWidth = 16;
+
+// Bit i is set when control byte i of the group equals `byte`
+std::uint32_t MatchByte(const std::int8_t* group, std::int8_t byte) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(byte))));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < kGroupWidth; ++i)
+        if (group[i] == byte) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+// Bit i is set when slot i of the group is empty or deleted
+std::uint32_t MatchFree(const std::int8_t* group) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < kGroupWidth; ++i)
+        if (group[i] < 0) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+// Spreads the input over all bits (murmur3 finalizer)
+std::size_t Mix(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<std::size_t>(h);
+}
+
+std::size_t HashKey(const PopLObject& key) {
+    if (key.isNumber()) {
+        double number = key.asNumber();
+        if (number == 0) number = 0;  // -0 and 0 are the same key
+        return Mix(std::bit_cast<std::uint64_t>(number));
+    }
+    if (key.isString())
+        return Mix(std::hash<std::string_view>{}(key.asString()));
+    return Mix(key.asBool() ? 1 : 2);
+}
+
+bool KeyEquals(const PopLObject& a, const PopLObject& b) {
+    if (a.isNumber())
+        return b.isNumber() && a.asNumber() == b.asNumber();
+    if (a.isString()) return b.isString() && a.asString() == b.asString();
+    return b.isBool() && a.asBool() == b.asBool();
+}
+
+// H1 picks the first group to probe, H2 goes into the control byte
+std::size_t H1(std::size_t hash) { return hash >> 7; }
+std::int8_t H2(std::size_t hash) {
+    return static_cast<std::int8_t>(hash & 0x7f);
+}
+}  // namespace
+
+PoplMap::PoplMap() { ChargeAlloc(sizeof(PoplMap)); }
+PoplMap::~PoplMap() = default;
+
+bool PoplMap::IsHashable(const PopLObject& key) {
+    if (key.isNumber()) return !std::isnan(key.asNumber());
+    return key.isString() || key.isBool();
+}
+
+// Probes whole groups, stepping 1, 2, 3, ... groups; with a power-of-two
+// group count this visits every group
+std::size_t PoplMap::FindSlot(const PopLObject& key, std::size_t hash) const {
+    if (m_size == 0) return npos;
+    std::size_t mask = Capacity() / kGroupWidth - 1;
+    for (std::size_t group = H1(hash) & mask, step = 0;;
+         group = (group + ++step) & mask) {
+        const std::int8_t* ctrl = &m_ctrl[group * kGroupWidth];
+        for (auto match = MatchByte(ctrl, H2(hash)); match;
+             match &= match - 1) {
+            const Slot& slot =
+                m_slots[group * kGroupWidth + std::countr_zero(match)];
+            if (slot.hash == hash && KeyEquals(slot.key, key))
+                return &slot - m_slots.data();
+        }
+        // An empty slot ends every probe sequence that passes through it
+        if (MatchByte(ctrl, kEmpty)) return npos;
+    }
+}
+
+std::size_t PoplMap::FindFree(std::size_t hash) const {
+    std::size_t mask = Capacity() / kGroupWidth - 1;
+    for (std::size_t group = H1(hash) & mask, step = 0;;
+         group = (group + ++step) & mask) {
+        if (auto free = MatchFree(&m_ctrl[group * kGroupWidth]))
+            return group * kGroupWidth + std::countr_zero(free);
+    }
+}
+
+const PopLObject* PoplMap::Find(const PopLObject& key) const {
+    std::size_t slot = FindSlot(key, HashKey(key));
+    return slot == npos ? nullptr : &m_slots[slot].value;
+}
+
+void PoplMap::Set(PopLObject key, PopLObject value) {
+    std::size_t hash = HashKey(key);
+    if (std::size_t slot = FindSlot(key, hash); slot != npos) {
+        m_slots[slot].value = std::move(value);
+        return;
+    }
+    // Keep at least 1/8 of the slots empty so that probes terminate; when
+    // tombstones are what fills the table, rehashing in place is enough
+    if ((m_size + m_deleted + 1) * 8 > Capacity() * 7)
+        Rehash((m_size + 1) * 16 > Capacity() * 7 ? Capacity() * 2
+                                                  : Capacity());
+
+    std::size_t slot = FindFree(hash);
+    if (m_ctrl[slot] == kDeleted) --m_deleted;
+    m_ctrl[slot]  = H2(hash);
+    m_slots[slot] = Slot{hash, std::move(key), std::move(value)};
+    ++m_size;
+}
+
+bool PoplMap::Erase(const PopLObject& key) {
+    std::size_t slot = FindSlot(key, HashKey(key));
+    if (slot == npos) return false;
+    // A tombstone, not an empty slot, so later probes keep walking past it
+    m_ctrl[slot]  = kDeleted;
+    m_slots[slot] = Slot{};
+    --m_size;
+    ++m_deleted;
+    return true;
+}
+
+void PoplMap::Rehash(std::size_t capacity) {
+    capacity = std::max(capacity, kGroupWidth);
+    ChargeAlloc(capacity * (sizeof(Slot) + 1));
+
+    auto old_ctrl  = std::exchange(m_ctrl, std::vector<std::int8_t>(
+                                               capacity, kEmpty));
+    auto old_slots = std::exchange(m_slots, std::vector<Slot>(capacity));
+    m_deleted      = 0;
+    for (std::size_t i = 0; i < old_ctrl.size(); ++i) {
+        if (old_ctrl[i] < 0) continue;
+        std::size_t slot = FindFree(old_slots[i].hash);
+        m_ctrl[slot]     = old_ctrl[i];
+        m_slots[slot]    = std::move(old_slots[i]);
+    }
+}
+
+void PoplMap::ForEach(const Visitor& visit) const {
+    for (std::size_t i = 0; i < Capacity(); ++i)
+        if (m_ctrl[i] >= 0) visit(m_slots[i].key, m_slots[i].value);
+}
+
+std::string PoplMap::ToString() const {
+    PrintGuard guard{this};
+    if (!guard.Entered()) return "{...}";
+    std::string out{"{"};
+    ForEach([&out, first = true](const PopLObject& key,
+                                 const PopLObject& value) mutable {
+        if (!first) out += ", ";
+        first = false;
+        out += key.toString() + ": " + value.toString();
+    });
+    return out + "}";
+}
+};  // namespace popl::runtime
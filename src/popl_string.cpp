@@ -0,0 +1,67 @@
+#include "popl/runtime/popl_string.hpp"
+
+#include <vector>
+
+namespace popl::runtime {
+
+PoplString::PoplString(Ptr left, Ptr right)
+    : m_left(std::move(left)),
+      m_right(std::move(right)),
+      m_size{m_left->Size() + m_right->Size()} {
+    ChargeAlloc(sizeof(PoplString));
+}
+
+// Children are unlinked iteratively: freeing a long `s = s + piece` chain
+// recursively would overflow the stack
+PoplString::~PoplString() {
+    if (!m_left) return;
+    std::vector<Ptr> pending;
+    pending.push_back(std::move(m_left));
+    pending.push_back(std::move(m_right));
+    while (!pending.empty()) {
+        Ptr node = std::move(pending.back());
+        pending.pop_back();
+        if (node.use_count() == 1 && node->m_left) {
+            pending.push_back(std::move(node->m_left));
+            pending.push_back(std::move(node->m_right));
+        }
+    }
+}
+
+PoplString::Ptr PoplString::Concat(const Ptr& left, const Ptr& right) {
+    if (left->Size() == 0) return right;
+    if (right->Size() == 0) return left;
+    std::size_t size = left->Size() + right->Size();
+    if (size >= kMinRopeSize)
+        return Ptr{new PoplString(left, right)};
+    ChargeAlloc(size);
+    std::string text;
+    text.reserve(size);
+    text.append(left->Get()).append(right->Get());
+    return std::make_shared<const PoplString>(std::move(text));
+}
+
+// Charged and built aside first: a node that fails to flatten stays a rope,
+// so reading it again does not append the leaves a second time
+void PoplString::Flatten() const {
+    ChargeAlloc(m_size);
+    std::string text;
+    text.reserve(m_size);
+    // In-order walk over the leaves and already flattened nodes
+    std::vector<const PoplString*> pending{m_right.get(), m_left.get()};
+    while (!pending.empty()) {
+        const PoplString* node = pending.back();
+        pending.pop_back();
+        if (node->m_left) {
+            pending.push_back(node->m_right.get());
+            pending.push_back(node->m_left.get());
+        } else {
+            text.append(node->m_text);
+        }
+    }
+    m_text = std::move(text);
+    m_left.reset();
+    m_right.reset();
+}
+
+}  // namespace popl::runtime
@@ -7,17 +7,22 @@
 #include "popl/diagnostics.hpp"
 #include "popl/syntax/ast/expr.hpp"
 #include "popl/syntax/ast/stmt.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
 
 namespace popl {
+Resolver::Resolver(Interpreter& interpreter)
+    : m_interpreter{interpreter},
+      m_diagnostics{interpreter.GetDiagnostics()} {}
+
 Resolver::ScopeGuard::~ScopeGuard() {
-    for (const auto& [_, info] : scopes.back()) {
+    for (const auto& [_, info] : resolver.m_scopes.back()) {
         if (info.defined && !info.used) {
-            Diagnostics::Error(
+            resolver.m_diagnostics.Error(
                 info.keyword,
                 "Unused local variable '" + info.keyword.GetLexeme() + "'.");
         }
     }
-    scopes.pop_back();
+    resolver.m_scopes.pop_back();
 }
 void Resolver::Resolve(Stmt& stmt) {
     visitStmtWithArgs(
@@ -38,7 +43,7 @@ void Resolver::Resolve(Expr& expr) {
 void Resolver::Declare(const Token& name) {
     if (m_scopes.empty()) return;
     if (m_scopes.back().contains(name.GetLexeme()))
-        Diagnostics::Error(
+        m_diagnostics.Error(
             name,
             std::format("Variable with name {} already exists in this scop.",
                         name.GetLexeme()));
@@ -54,12 +59,43 @@ void Resolver::Define(const Token& name) {
         VariableInfo{.defined = true, .used = false, .keyword = name});
 }
 
+int Resolver::ResolveUpvalue(std::size_t level, std::size_t scope,
+                             const Token& name) {
+    Upvalue upvalue{.name = name, .isLocal = true, .index = 0};
+    // Relative to the scope enclosing the function, where it is created
+    std::size_t created = m_functions[level].base - 1;
+    if (level == 0 || scope >= m_functions[level - 1].base) {
+        upvalue.index = static_cast<int>(created - scope);
+    } else {
+        upvalue.isLocal = false;
+        upvalue.index   = ResolveUpvalue(level - 1, scope, name);
+    }
+
+    auto& upvalues = m_functions[level].function->upvalues;
+    for (std::size_t i = 0; i < upvalues.size(); ++i) {
+        if (upvalues[i].isLocal == upvalue.isLocal &&
+            upvalues[i].index == upvalue.index &&
+            upvalues[i].name.GetLexeme() == name.GetLexeme())
+            return static_cast<int>(i);
+    }
+    upvalues.push_back(std::move(upvalue));
+    return static_cast<int>(upvalues.size()) - 1;
+}
+
 void Resolver::Resolve(std::vector<std::unique_ptr<Stmt>>& statements) {
     for (auto& stmt : statements) Resolve(*stmt);
 }
 
 void Resolver::ResolveFunction(FunctionExpr& expr, FunctionType funcType) {
-    ScopeGuard guard(m_scopes);
+    // A method's scopes include the one holding `this`, which Bind() recreates
+    // for every bound method
+    std::size_t base = m_scopes.size();
+    if (funcType == FunctionType::METHOD ||
+        funcType == FunctionType::INITIALIZER)
+        --base;
+    ScopeGuard guard(*this);
+    expr.upvalues.clear();
+    m_functions.push_back({&expr, base});
 
     FunctionType enclosingFunction = m_current_function_type;
     m_current_function_type        = funcType;
@@ -69,6 +105,7 @@ void Resolver::ResolveFunction(FunctionExpr& expr, FunctionType funcType) {
         Define(param);
     }
     Resolve(expr.body);
+    m_functions.pop_back();
     m_current_function_type = enclosingFunction;
 }
 
@@ -78,7 +115,7 @@ void Resolver::operator()(VarStmt& stmt, Stmt&) {
     Define(stmt.name);
 }
 void Resolver::operator()(BlockStmt& stmt, Stmt&) {
-    ScopeGuard guard(m_scopes);
+    ScopeGuard guard(*this);
     Resolve(stmt.statements);
 }
 void Resolver::operator()(FunctionStmt& stmt, Stmt&) {
@@ -93,7 +130,7 @@ void Resolver::operator()(ClassStmt& stmt, Stmt&) {
     Declare(stmt.name);
     Define(stmt.name);
 
-    ScopeGuard guard{m_scopes};
+    ScopeGuard guard{*this};
 
     m_scopes.back().insert_or_assign(
         "this",
@@ -133,21 +170,21 @@ void Resolver::operator()(WhileStmt& stmt, Stmt&) {
 }
 void Resolver::operator()(BreakStmt& stmt, Stmt&) {
     if (m_current_loop_type != LoopType::LOOP)
-        Diagnostics::Error(stmt.keyword,
-                           "'break' statement not inside a loop.");
+        m_diagnostics.Error(stmt.keyword,
+                            "'break' statement not inside a loop.");
 }
 void Resolver::operator()(ContinueStmt& stmt, Stmt&) {
     if (m_current_loop_type != LoopType::LOOP)
-        Diagnostics::Error(stmt.keyword,
-                           "'continue' statement not inside a loop.");
+        m_diagnostics.Error(stmt.keyword,
+                            "'continue' statement not inside a loop.");
 }
 void Resolver::operator()(ReturnStmt& stmt, Stmt&) {
     if (m_current_function_type == FunctionType::NONE) {
-        Diagnostics::Error(stmt.keyword, "Can't return from top-level code.");
+        m_diagnostics.Error(stmt.keyword, "Can't return from top-level code.");
     }
     if (m_current_function_type == FunctionType::INITIALIZER) {
-        Diagnostics::Error(stmt.keyword,
-                           "Can't return a value from an initializer");
+        m_diagnostics.Error(stmt.keyword,
+                            "Can't return a value from an initializer");
     }
     if (stmt.value) Resolve(*stmt.value);
 }
@@ -158,7 +195,7 @@ void Resolver::operator()(VariableExpr& expr, Expr&) {
         auto  it           = currentScope.find(expr.name.GetLexeme());
 
         if (it != currentScope.end() && it->second.defined == false) {
-            Diagnostics::Error(
+            m_diagnostics.Error(
                 expr.name, "Can't read local variable in its own initializer.");
         }
     }
@@ -175,7 +212,7 @@ void Resolver::operator()(AssignExpr& expr, Expr&) {
         auto& currentScope = m_scopes.back();
         auto  it           = currentScope.find(expr.name.GetLexeme());
         if (it != currentScope.end() && it->second.defined == false) {
-            Diagnostics::Error(
+            m_diagnostics.Error(
                 expr.name, "Can't read local variable in its own initializer.");
         }
     }
@@ -209,11 +246,35 @@ void Resolver::operator()(SetExpr& expr, Expr&) {
     Resolve(*expr.value);
     Resolve(*expr.object);
 }
+void Resolver::operator()(ArrayExpr& expr, Expr&) {
+    for (auto& element : expr.elements) Resolve(*element);
+}
+void Resolver::operator()(IndexExpr& expr, Expr&) {
+    Resolve(*expr.object);
+    Resolve(*expr.index);
+}
+void Resolver::operator()(IndexSetExpr& expr, Expr&) {
+    Resolve(*expr.value);
+    Resolve(*expr.object);
+    Resolve(*expr.index);
+}
+void Resolver::operator()(MapExpr& expr, Expr&) {
+    for (std::size_t i = 0; i < expr.keys.size(); ++i) {
+        Resolve(*expr.keys[i]);
+        Resolve(*expr.values[i]);
+    }
+}
 void Resolver::operator()(ThisExpr& expr, Expr&) {
     if (m_current_class_type != ClassType::CLASS) {
-        Diagnostics::Error(expr.keyword, "Can't use this outside of class.");
+        m_diagnostics.Error(expr.keyword, "Can't use this outside of class.");
         return;
     }
     ResolveLocal(expr, expr.keyword);
 }
+// Fused and invariant nodes come from the optimization passes, after
+// resolution, and already carry the resolution of the nodes they replace
+void Resolver::operator()(IncrementExpr& expr, Expr&) {}
+void Resolver::operator()(CompareExpr& expr, Expr&) {}
+void Resolver::operator()(ThisGetExpr& expr, Expr&) {}
+void Resolver::operator()(InvariantExpr& expr, Expr&) {}
 };  // namespace popl
@@ -0,0 +1,41 @@
+#include "popl/runtime/stats.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <print>
+
+namespace popl::runtime {
+
+Stats& GetStats() {
+    thread_local Stats stats{};
+    return stats;
+}
+
+void Stats::Print(std::FILE* out) const {
+    auto ms = [](Duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::println(out, "---- popl statistics ----");
+    std::println(out, "environments created : {} ({} on the stack)",
+                 environments_created, stack_environments);
+    std::println(out, "instances created    : {}", instances_created);
+    std::println(out, "functions created    : {} ({} from Bind)",
+                 functions_created, bound_methods_created);
+    std::println(out, "strings concatenated : {}", strings_concatenated);
+    std::println(out, "peak live objects    : {}", peak_live_objects);
+    std::println(out, "calls executed       : {}", calls_executed);
+    std::println(out, "statements executed  : {}", statements_executed);
+    std::println(out, "max call depth       : {}", max_call_depth);
+    std::println(out, "fused nodes executed : {} increments, {} compares, "
+                 "{} this gets",
+                 fused_increments, fused_compares, fused_this_gets);
+    std::println(out, "invariants reused    : {}", invariants_reused);
+    std::println(out, "statements removed   : {}", statements_removed);
+    std::println(out, "lex time             : {:.3f} ms", ms(lex_time));
+    std::println(out, "parse time           : {:.3f} ms", ms(parse_time));
+    std::println(out, "resolve time         : {:.3f} ms", ms(resolve_time));
+    std::println(out, "optimize time        : {:.3f} ms", ms(optimize_time));
+    std::println(out, "interpret time       : {:.3f} ms", ms(interpret_time));
+}
+
+}  // namespace popl::runtime
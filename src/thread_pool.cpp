@@ -0,0 +1,59 @@
+#include "popl/runtime/thread_pool.hpp"
+
+#include <system_error>
+#include <utility>
+
+namespace popl::runtime {
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{m_mutex};
+        m_stopping = true;
+    }
+    m_has_task.notify_all();
+    for (auto& thread : m_threads) thread.join();
+}
+
+bool ThreadPool::Submit(Task task) {
+    {
+        std::lock_guard lock{m_mutex};
+        // Idle threads that were already notified still count as idle until
+        // they take a task, hence the comparison against the queue length
+        if (m_tasks.size() >= m_idle) {
+            if (m_threads.size() >= m_max_threads) return false;
+            try {
+                m_threads.emplace_back([this] { WorkerLoop(); });
+            } catch (const std::system_error&) {
+                return false;
+            }
+        }
+        m_tasks.push_back(std::move(task));
+    }
+    m_has_task.notify_one();
+    return true;
+}
+
+void ThreadPool::WorkerLoop() {
+    std::unique_lock lock{m_mutex};
+    for (;;) {
+        ++m_idle;
+        m_has_task.wait(lock,
+                        [this] { return m_stopping || !m_tasks.empty(); });
+        --m_idle;
+        if (m_tasks.empty()) return;  // stopping
+
+        Task task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+        task = nullptr;  // release captures outside the lock
+        lock.lock();
+    }
+}
+
+}  // namespace popl::runtime
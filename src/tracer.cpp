@@ -0,0 +1,97 @@
+#include "popl/runtime/tracer.hpp"
+
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace popl::runtime {
+
+static std::string_view CategoryName(TraceCategory category) {
+    switch (category) {
+        case TraceCategory::PHASE:
+            return "phase";
+        case TraceCategory::POPL_CALL:
+            return "popl";
+        case TraceCategory::NATIVE_CALL:
+            return "native";
+    }
+    return "unknown";
+}
+
+static std::string EscapeJson(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    out += std::format("\\u{:04x}", static_cast<int>(c));
+                else
+                    out += c;
+        }
+    }
+    return out;
+}
+
+Tracer::Tracer() : m_start{Clock::now()} { m_events.reserve(1 << 16); }
+
+std::uint32_t Tracer::Intern(std::string_view name) {
+    auto it = m_name_ids.find(name);
+    if (it != m_name_ids.end()) return it->second;
+    auto id = static_cast<std::uint32_t>(m_names.size());
+    m_names.emplace_back(name);
+    m_name_ids.emplace(m_names.back(), id);
+    return id;
+}
+
+void Tracer::Begin(std::string_view name, TraceCategory category) {
+    Event event{Now(), Intern(name), category, 'B'};
+    m_open.push_back(event);
+    m_events.push_back(event);
+}
+
+void Tracer::End() {
+    if (m_open.empty()) return;
+    Event begin = m_open.back();
+    m_open.pop_back();
+    m_events.push_back(Event{Now(), begin.name_id, begin.category, 'E'});
+}
+
+void Tracer::Write(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("Failed to open trace file '" + path + "'");
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& event : m_events) {
+        if (!first) out << ",\n";
+        first = false;
+        // trace-event timestamps are microseconds
+        out << std::format(
+            "{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"{}\",\"ts\":{:.3f},"
+            "\"pid\":1,\"tid\":1}}",
+            EscapeJson(m_names[event.name_id]), CategoryName(event.category),
+            event.phase, static_cast<double>(event.timestamp_ns) / 1000.0);
+    }
+    out << "\n]}\n";
+    if (!out)
+        throw std::runtime_error("Failed to write trace file '" + path + "'");
+}
+
+}  // namespace popl::runtime
@@ -0,0 +1,229 @@
+#include "popl/runtime/transfer.hpp"
+
+#include <memory>
+#include <unordered_map>
+
+#include "popl/callables/native_functions.hpp"
+#include "popl/callables/popl_function.hpp"
+#include "popl/runtime/float64_array.hpp"
+#include "popl/runtime/popl_array.hpp"
+#include "popl/runtime/popl_class.hpp"
+#include "popl/runtime/popl_instance.hpp"
+#include "popl/runtime/popl_map.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
+
+namespace popl::runtime {
+
+using callable::PoplFunction;
+
+// Copies an object graph, preserving sharing and cycles. Every object is
+// registered before its children are copied; as copying a child can reach the
+// parent again, the memo is re-checked after the children are done. Source
+// objects are only read through raw pointers: their reference counts are not
+// atomic and several Attachers may read the same graph at once.
+class GraphCopier {
+   public:
+    GraphCopier(const Environment* from_root, Ref<Environment> to_root) {
+        m_environments.emplace(from_root, std::move(to_root));
+    }
+
+    PopLObject Copy(const PopLObject& value) {
+        if (value.isInstance())
+            return PopLObject{CopyInstance(value.asInstance().get())};
+        if (value.isCallable())
+            return PopLObject{CopyCallable(value.asCallable().get())};
+        if (value.isArray()) return PopLObject{CopyArray(value.asArray())};
+        if (value.isMap()) return PopLObject{CopyMap(value.asMap())};
+        if (value.isFloat64Array())
+            return PopLObject{CopyFloat64Array(value.asFloat64Array())};
+        // Flat strings are never mutated and may be shared across threads;
+        // ropes flatten on this (the owning) thread first
+        if (value.isString()) value.asString();
+        return value;  // plain values are copied by value anyway
+    }
+
+   private:
+    Ref<Environment> CopyEnvironment(const Environment* env) {
+        if (!env) return nullptr;
+        if (auto copy = Find(m_environments, env)) return copy;
+
+        auto enclosing = CopyEnvironment(env->GetEnclosing().get());
+        if (auto copy = Find(m_environments, env)) return copy;
+        auto copy = enclosing ? Environment::Make(std::move(enclosing))
+                              : Environment::Make();
+        m_environments.emplace(env, copy);
+        for (const auto& [name, value] : env->GetValues())
+            copy->Define(name, Copy(value));
+        for (const auto& [name, cell] : env->GetCells())
+            copy->DefineCell(name, CopyCell(cell.get()));
+        return copy;
+    }
+
+    Ref<Cell> CopyCell(const Cell* cell) {
+        if (auto copy = Find(m_cells, cell)) return copy;
+
+        auto copy = MakeRef<Cell>(PopLObject{UninitializedValue{}});
+        m_cells.emplace(cell, copy);
+        copy->value = Copy(cell->value);
+        return copy;
+    }
+
+    PopLObject::CallablePtr CopyCallable(
+        const callable::PoplCallable* callable) {
+        if (auto copy = Find(m_callables, callable)) return copy;
+
+        PopLObject::CallablePtr copy;
+        if (auto function = dynamic_cast<const PoplFunction*>(callable)) {
+            auto closure = CopyEnvironment(function->GetClosure().get());
+            Upvalues upvalues{CurrentResource()};
+            upvalues.reserve(function->GetUpvalues().size());
+            for (const auto& cell : function->GetUpvalues())
+                upvalues.push_back(CopyCell(cell.get()));
+            if (auto done = Find(m_callables, callable)) return done;
+            copy = MakeRef<PoplFunction>(
+                function->GetDeclaration(), std::move(closure),
+                function->GetName(), function->IsInitializer(),
+                std::move(upvalues));
+        } else if (auto klass = dynamic_cast<const PoplClass*>(callable)) {
+            std::unordered_map<std::string, Ref<PoplFunction>> methods;
+            for (const auto& [name, method] : klass->GetMethods())
+                methods.emplace(name, StaticRefCast<PoplFunction>(
+                                          CopyCallable(method.get())));
+            if (auto done = Find(m_callables, callable)) return done;
+            copy = MakeRef<PoplClass>(klass->GetName(), std::move(methods));
+        } else {
+            // Natives hold no per-interpreter state, but sharing one would
+            // share its reference count
+            copy = MakeRef<callable::NativeFunction>(
+                dynamic_cast<const callable::NativeFunction&>(*callable));
+        }
+        m_callables.emplace(callable, copy);
+        return copy;
+    }
+
+    PopLObject::InstancePtr CopyInstance(const PoplInstance* instance) {
+        if (auto copy = Find(m_instances, instance)) return copy;
+
+        auto klass = StaticRefCast<PoplClass>(
+            CopyCallable(instance->GetClass().get()));
+        if (auto copy = Find(m_instances, instance)) return copy;
+        auto copy = MakeRef<PoplInstance>(std::move(klass));
+        m_instances.emplace(instance, copy);
+        for (const auto& [name, value] : instance->GetFields())
+            copy->Set(name, Copy(value));
+        return copy;
+    }
+
+    PopLObject::ArrayPtr CopyArray(const PopLObject::ArrayPtr& array) {
+        if (auto copy = Find(m_arrays, array.get())) return copy;
+
+        auto copy = std::make_shared<PoplArray>();
+        m_arrays.emplace(array.get(), copy);
+        auto& elements = copy->GetElements();
+        elements.reserve(array->Size());
+        for (const auto& element : array->GetElements())
+            elements.push_back(Copy(element));
+        return copy;
+    }
+
+    PopLObject::MapPtr CopyMap(const PopLObject::MapPtr& map) {
+        if (auto copy = Find(m_maps, map.get())) return copy;
+
+        auto copy = std::make_shared<PoplMap>();
+        m_maps.emplace(map.get(), copy);
+        // Keys are plain values, only the values can hold references
+        map->ForEach([&](const PopLObject& key, const PopLObject& value) {
+            copy->Set(key, Copy(value));
+        });
+        return copy;
+    }
+
+    PopLObject::Float64ArrayPtr CopyFloat64Array(
+        const PopLObject::Float64ArrayPtr& array) {
+        if (auto copy = Find(m_float64_arrays, array.get())) return copy;
+
+        auto copy = std::make_shared<Float64Array>(std::vector<double>(
+            array->Data(), array->Data() + array->Size()));
+        m_float64_arrays.emplace(array.get(), copy);
+        return copy;
+    }
+
+    template <typename Map, typename Key>
+    static typename Map::mapped_type Find(const Map& memo, Key key) {
+        auto it = memo.find(key);
+        return it != memo.end() ? it->second : nullptr;
+    }
+
+   private:
+    std::unordered_map<const Environment*, Ref<Environment>> m_environments;
+    std::unordered_map<const Cell*, Ref<Cell>>               m_cells;
+    std::unordered_map<const callable::PoplCallable*, PopLObject::CallablePtr>
+        m_callables;
+    std::unordered_map<const PoplInstance*, PopLObject::InstancePtr>
+        m_instances;
+    std::unordered_map<const PoplArray*, PopLObject::ArrayPtr> m_arrays;
+    std::unordered_map<const PoplMap*, PopLObject::MapPtr>     m_maps;
+    std::unordered_map<const Float64Array*, PopLObject::Float64ArrayPtr>
+        m_float64_arrays;
+};
+
+namespace {
+bool IsNative(const PopLObject& value) {
+    return value.isCallable() &&
+           dynamic_cast<callable::NativeFunction*>(value.asCallable().get());
+}
+}  // namespace
+
+DetachedGraph Detach(Interpreter& from, const std::vector<PopLObject>& values,
+                     bool with_globals) {
+    // The graph may be freed on another thread, so it must not use `from`'s
+    // object pool
+    CurrentPoolScope detached{nullptr};
+    DetachedGraph    graph;
+    const auto&   from_globals = from.GetGlobalEnvironment();
+    GraphCopier   copier{from_globals.get(), graph.globals};
+    if (with_globals) {
+        for (const auto& [name, value] : from_globals->GetValues())
+            graph.globals->Define(name, copier.Copy(value));
+    }
+    graph.values.reserve(values.size());
+    for (const auto& value : values) graph.values.push_back(copier.Copy(value));
+    return graph;
+}
+
+std::vector<PopLObject> Attach(Interpreter& to, const DetachedGraph& graph) {
+    Attacher                attacher{to, graph};
+    std::vector<PopLObject> values;
+    values.reserve(graph.values.size());
+    for (const auto& value : graph.values)
+        values.push_back(attacher.Copy(value));
+    return values;
+}
+
+std::vector<PopLObject> Transfer(Interpreter& from, Interpreter& to,
+                                 const std::vector<PopLObject>& values) {
+    GraphCopier copier{from.GetGlobalEnvironment().get(),
+                       to.GetGlobalEnvironment()};
+    std::vector<PopLObject> copies;
+    copies.reserve(values.size());
+    for (const auto& value : values) copies.push_back(copier.Copy(value));
+    return copies;
+}
+
+Attacher::Attacher(Interpreter& to, const DetachedGraph& graph)
+    : m_copier{std::make_unique<GraphCopier>(graph.globals.get(),
+                                             to.GetGlobalEnvironment())} {
+    const auto& to_globals = to.GetGlobalEnvironment();
+    for (const auto& [name, value] : graph.globals->GetValues()) {
+        // The receiver registered its own natives already
+        if (IsNative(value) && to_globals->GetValues().contains(name)) continue;
+        to_globals->Define(name, m_copier->Copy(value));
+    }
+}
+Attacher::~Attacher() = default;
+
+PopLObject Attacher::Copy(const PopLObject& value) {
+    return m_copier->Copy(value);
+}
+
+}  // namespace popl::runtime
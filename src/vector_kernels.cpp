@@ -0,0 +1,237 @@
+#include "popl/runtime/vector_kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace popl::runtime {
+
+namespace {
+namespace scalar {
+double Sum(const double* x, std::size_t n) {
+    double total = 0;
+    for (std::size_t i = 0; i < n; ++i) total += x[i];
+    return total;
+}
+double Dot(const double* x, const double* y, std::size_t n) {
+    double total = 0;
+    for (std::size_t i = 0; i < n; ++i) total += x[i] * y[i];
+    return total;
+}
+void Axpy(double alpha, const double* x, double* y, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+void Add(const double* x, const double* y, double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = x[i] + y[i];
+}
+void Mul(const double* x, const double* y, double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = x[i] * y[i];
+}
+double Min(const double* x, std::size_t n) {
+    return *std::min_element(x, x + n);
+}
+double Max(const double* x, std::size_t n) {
+    return *std::max_element(x, x + n);
+}
+void PrefixSum(const double* x, double* out, std::size_t n) {
+    double total = 0;
+    for (std::size_t i = 0; i < n; ++i) out[i] = total += x[i];
+}
+}  // namespace scalar
+
+#if defined(__x86_64__)
+// SSE2 is part of x86-64, so these need no runtime check
+namespace sse2 {
+double Sum(const double* x, std::size_t n) {
+    __m128d     a = _mm_setzero_pd(), b = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a = _mm_add_pd(a, _mm_loadu_pd(x + i));
+        b = _mm_add_pd(b, _mm_loadu_pd(x + i + 2));
+    }
+    a = _mm_add_pd(a, b);
+    a = _mm_add_sd(a, _mm_unpackhi_pd(a, a));
+    return _mm_cvtsd_f64(a) + scalar::Sum(x + i, n - i);
+}
+double Dot(const double* x, const double* y, std::size_t n) {
+    __m128d     a = _mm_setzero_pd(), b = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a = _mm_add_pd(a, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        b = _mm_add_pd(
+            b, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+    }
+    a = _mm_add_pd(a, b);
+    a = _mm_add_sd(a, _mm_unpackhi_pd(a, a));
+    return _mm_cvtsd_f64(a) + scalar::Dot(x + i, y + i, n - i);
+}
+void Axpy(double alpha, const double* x, double* y, std::size_t n) {
+    __m128d     a = _mm_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i),
+                                        _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+    scalar::Axpy(alpha, x + i, y + i, n - i);
+}
+void Add(const double* x, const double* y, double* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i,
+                      _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    scalar::Add(x + i, y + i, out + i, n - i);
+}
+void Mul(const double* x, const double* y, double* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i,
+                      _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    scalar::Mul(x + i, y + i, out + i, n - i);
+}
+double Min(const double* x, std::size_t n) {
+    if (n < 2) return scalar::Min(x, n);
+    __m128d     m = _mm_loadu_pd(x);
+    std::size_t i = 2;
+    for (; i + 2 <= n; i += 2) m = _mm_min_pd(m, _mm_loadu_pd(x + i));
+    m = _mm_min_sd(m, _mm_unpackhi_pd(m, m));
+    return i < n ? std::min(_mm_cvtsd_f64(m), x[i]) : _mm_cvtsd_f64(m);
+}
+double Max(const double* x, std::size_t n) {
+    if (n < 2) return scalar::Max(x, n);
+    __m128d     m = _mm_loadu_pd(x);
+    std::size_t i = 2;
+    for (; i + 2 <= n; i += 2) m = _mm_max_pd(m, _mm_loadu_pd(x + i));
+    m = _mm_max_sd(m, _mm_unpackhi_pd(m, m));
+    return i < n ? std::max(_mm_cvtsd_f64(m), x[i]) : _mm_cvtsd_f64(m);
+}
+void PrefixSum(const double* x, double* out, std::size_t n) {
+    __m128d     carry = _mm_setzero_pd();
+    std::size_t i     = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(x + i);
+        // [a, b] -> [a, a + b]
+        v = _mm_add_pd(v, _mm_unpacklo_pd(_mm_setzero_pd(), v));
+        v = _mm_add_pd(v, carry);
+        _mm_storeu_pd(out + i, v);
+        carry = _mm_unpackhi_pd(v, v);
+    }
+    double total = _mm_cvtsd_f64(carry);
+    for (; i < n; ++i) out[i] = total += x[i];
+}
+}  // namespace sse2
+
+#define POPL_AVX2 __attribute__((target("avx2,fma")))
+namespace avx2 {
+POPL_AVX2 double Reduce(__m256d v) {
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(v),
+                              _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+POPL_AVX2 double Sum(const double* x, std::size_t n) {
+    __m256d     a = _mm256_setzero_pd(), b = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a = _mm256_add_pd(a, _mm256_loadu_pd(x + i));
+        b = _mm256_add_pd(b, _mm256_loadu_pd(x + i + 4));
+    }
+    return Reduce(_mm256_add_pd(a, b)) + sse2::Sum(x + i, n - i);
+}
+POPL_AVX2 double Dot(const double* x, const double* y, std::size_t n) {
+    __m256d     a = _mm256_setzero_pd(), b = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a);
+        b = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4),
+                            _mm256_loadu_pd(y + i + 4), b);
+    }
+    return Reduce(_mm256_add_pd(a, b)) + sse2::Dot(x + i, y + i, n - i);
+}
+POPL_AVX2 void Axpy(double alpha, const double* x, double* y, std::size_t n) {
+    __m256d     a = _mm256_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i),
+                                                _mm256_loadu_pd(y + i)));
+    sse2::Axpy(alpha, x + i, y + i, n - i);
+}
+POPL_AVX2 void Add(const double* x, const double* y, double* out,
+                   std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i),
+                                                _mm256_loadu_pd(y + i)));
+    sse2::Add(x + i, y + i, out + i, n - i);
+}
+POPL_AVX2 void Mul(const double* x, const double* y, double* out,
+                   std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i),
+                                                _mm256_loadu_pd(y + i)));
+    sse2::Mul(x + i, y + i, out + i, n - i);
+}
+POPL_AVX2 double Min(const double* x, std::size_t n) {
+    if (n < 4) return sse2::Min(x, n);
+    __m256d     m = _mm256_loadu_pd(x);
+    std::size_t i = 4;
+    for (; i + 4 <= n; i += 4) m = _mm256_min_pd(m, _mm256_loadu_pd(x + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double tail = i < n ? sse2::Min(x + i, n - i) : lanes[0];
+    return std::min({lanes[0], lanes[1], lanes[2], lanes[3], tail});
+}
+POPL_AVX2 double Max(const double* x, std::size_t n) {
+    if (n < 4) return sse2::Max(x, n);
+    __m256d     m = _mm256_loadu_pd(x);
+    std::size_t i = 4;
+    for (; i + 4 <= n; i += 4) m = _mm256_max_pd(m, _mm256_loadu_pd(x + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double tail = i < n ? sse2::Max(x + i, n - i) : lanes[0];
+    return std::max({lanes[0], lanes[1], lanes[2], lanes[3], tail});
+}
+POPL_AVX2 void PrefixSum(const double* x, double* out, std::size_t n) {
+    __m256d     zero  = _mm256_setzero_pd();
+    __m256d     carry = zero;
+    std::size_t i     = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        // In-register scan: add the vector shifted up by one, then by two
+        // lanes
+        v = _mm256_add_pd(
+            v, _mm256_blend_pd(_mm256_permute4x64_pd(v, 0x90), zero, 0x1));
+        v = _mm256_add_pd(v, _mm256_permute2f128_pd(v, v, 0x08));
+        v = _mm256_add_pd(v, carry);
+        _mm256_storeu_pd(out + i, v);
+        carry = _mm256_permute4x64_pd(v, 0xff);
+    }
+    double total = _mm256_cvtsd_f64(carry);
+    for (; i < n; ++i) out[i] = total += x[i];
+}
+}  // namespace avx2
+#undef POPL_AVX2
+#endif
+}  // namespace
+
+const VectorKernels& VectorKernels::Get() {
+    static const VectorKernels kernels = [] {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return VectorKernels{"avx2",      avx2::Sum, avx2::Dot,
+                                 avx2::Axpy,  avx2::Add, avx2::Mul,
+                                 avx2::Min,   avx2::Max, avx2::PrefixSum};
+        return VectorKernels{"sse2",     sse2::Sum, sse2::Dot,
+                             sse2::Axpy, sse2::Add, sse2::Mul,
+                             sse2::Min,  sse2::Max, sse2::PrefixSum};
+#else
+        return VectorKernels{"scalar",     scalar::Sum, scalar::Dot,
+                             scalar::Axpy, scalar::Add, scalar::Mul,
+                             scalar::Min,  scalar::Max, scalar::PrefixSum};
+#endif
+    }();
+    return kernels;
+}
+
+}  // namespace popl::runtime
@@ -0,0 +1,120 @@
+#include "popl/runtime/work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace popl::runtime {
+
+struct WorkStealingPool::Job {
+    using Chunk = std::pair<std::size_t, std::size_t>;
+
+    struct Queue {
+        std::mutex        mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    explicit Job(const Body& body_, unsigned participants)
+        : body{body_}, queues(participants) {}
+
+    std::optional<Chunk> Pop(unsigned participant) {
+        auto&           own = queues[participant];
+        std::lock_guard lock{own.mutex};
+        if (own.chunks.empty()) return std::nullopt;
+        Chunk chunk = own.chunks.front();
+        own.chunks.pop_front();
+        return chunk;
+    }
+    std::optional<Chunk> Steal(unsigned thief) {
+        for (std::size_t i = 1; i < queues.size(); ++i) {
+            auto&           victim = queues[(thief + i) % queues.size()];
+            std::lock_guard lock{victim.mutex};
+            if (victim.chunks.empty()) continue;
+            Chunk chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            return chunk;
+        }
+        return std::nullopt;
+    }
+
+    const Body&        body;
+    std::vector<Queue> queues;
+    std::atomic<bool>  cancelled{false};
+
+    std::mutex              mutex;
+    std::condition_variable all_done;
+    unsigned                running{0};
+    bool                    closed{false};  // late participants must not start
+    std::exception_ptr      error{};
+};
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+    : m_concurrency{std::max(1u, threads)} {}
+
+WorkStealingPool& WorkStealingPool::Shared() {
+    static WorkStealingPool pool{std::thread::hardware_concurrency()};
+    return pool;
+}
+
+void WorkStealingPool::ParallelFor(std::size_t count, std::size_t grain,
+                                   const Body& body) {
+    if (count == 0) return;
+    grain = std::max<std::size_t>(1, grain);
+
+    std::size_t chunks       = (count + grain - 1) / grain;
+    auto        participants = static_cast<unsigned>(
+        std::min<std::size_t>(m_concurrency, chunks));
+    auto job = std::make_shared<Job>(body, participants);
+
+    // Contiguous runs of chunks per participant keep neighbours together
+    for (std::size_t c = 0; c < chunks; ++c) {
+        auto owner = static_cast<unsigned>(c * participants / chunks);
+        job->queues[owner].chunks.emplace_back(
+            c * grain, std::min(count, (c + 1) * grain));
+    }
+
+    // A participant the pool has no thread for is left out; the others steal
+    // its chunks
+    for (unsigned p = 1; p < participants; ++p) {
+        (void)m_threads.Submit([job, p] {
+            {
+                std::lock_guard lock{job->mutex};
+                if (job->closed) return;
+                ++job->running;
+            }
+            Participate(*job, p);
+            std::lock_guard lock{job->mutex};
+            if (--job->running == 0) job->all_done.notify_all();
+        });
+    }
+    Participate(*job, 0);
+
+    std::unique_lock lock{job->mutex};
+    job->closed = true;
+    job->all_done.wait(lock, [&] { return job->running == 0; });
+    if (job->error) std::rethrow_exception(job->error);
+}
+
+void WorkStealingPool::Participate(Job& job, unsigned participant) {
+    while (!job.cancelled.load(std::memory_order_relaxed)) {
+        auto chunk = job.Pop(participant);
+        if (!chunk) chunk = job.Steal(participant);
+        if (!chunk) return;
+        try {
+            job.body(participant, chunk->first, chunk->second);
+        } catch (...) {
+            std::lock_guard lock{job.mutex};
+            if (!job.error) job.error = std::current_exception();
+            job.cancelled = true;
+        }
+    }
+}
+
+}  // namespace popl::runtime
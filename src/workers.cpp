@@ -0,0 +1,123 @@
+#include "popl/runtime/workers.hpp"
+
+#include <exception>
+#include <utility>
+
+#include "popl/runtime/thread_pool.hpp"
+#include "popl/syntax/visitors/interpreter.hpp"
+
+namespace popl::runtime {
+
+bool Channel::Send(DetachedGraph value) {
+    {
+        std::unique_lock lock{m_mutex};
+        m_not_full.wait(lock, [this] {
+            return m_closed || m_queue.size() < m_capacity;
+        });
+        if (m_closed) return false;
+        m_queue.push_back(std::move(value));
+    }
+    m_not_empty.notify_one();
+    return true;
+}
+
+std::optional<DetachedGraph> Channel::Receive() {
+    std::optional<DetachedGraph> value;
+    {
+        std::unique_lock lock{m_mutex};
+        m_not_empty.wait(lock, [this] { return m_closed || !m_queue.empty(); });
+        if (m_queue.empty()) return std::nullopt;
+        value = std::move(m_queue.front());
+        m_queue.pop_front();
+    }
+    m_not_full.notify_one();
+    return value;
+}
+
+void Channel::Close() {
+    {
+        std::lock_guard lock{m_mutex};
+        m_closed = true;
+    }
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+}
+
+std::optional<WorkerGroup::Id> WorkerGroup::Spawn(Interpreter&      parent,
+                                                  const PopLObject& callee,
+                                                  const PopLObject& arg) {
+    // Copied on the parent's thread, while nothing else can touch its heap
+    auto task    = Detach(parent, {callee, arg}, /*with_globals=*/true);
+    // The worker buffers its own output; what the parent printed comes first
+    parent.GetOutput().Flush();
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto future  = promise->get_future();
+
+    bool started = ThreadPool::Shared().Submit([task = std::move(task), promise,
+                                                meter = parent.GetMeter(),
+                                                group = shared_from_this()] {
+        Result result;
+        {
+            Interpreter worker;
+            worker.InheritBudget(meter);
+            worker.JoinWorkerGroup(group);
+            try {
+                auto values = Attach(worker, task);
+                auto value  = worker.CallFunction(values[0], {&values[1], 1});
+                result      = Detach(worker, {value});
+            } catch (const std::exception& error) {
+                result = std::unexpected{std::string{error.what()}};
+            }
+        }
+        promise->set_value(std::move(result));
+    });
+    if (!started) return std::nullopt;
+
+    std::lock_guard lock{m_mutex};
+    Id              id = m_next_worker++;
+    m_workers.emplace(id, std::move(future));
+    return id;
+}
+
+std::optional<WorkerGroup::Result> WorkerGroup::Join(Id id) {
+    std::future<Result> worker;
+    {
+        std::lock_guard lock{m_mutex};
+        auto            it = m_workers.find(id);
+        if (it == m_workers.end()) return std::nullopt;
+        worker = std::move(it->second);
+        m_workers.erase(it);
+    }
+    return worker.get();
+}
+
+WorkerGroup::Id WorkerGroup::NewChannel(std::size_t capacity) {
+    std::lock_guard lock{m_mutex};
+    Id              id = m_next_channel++;
+    m_channels.emplace(id, std::make_shared<Channel>(capacity));
+    return id;
+}
+
+std::shared_ptr<Channel> WorkerGroup::GetChannel(Id id) const {
+    std::lock_guard lock{m_mutex};
+    auto            it = m_channels.find(id);
+    return it != m_channels.end() ? it->second : nullptr;
+}
+
+void WorkerGroup::Shutdown() {
+    // Workers may still spawn workers of their own while we wait
+    for (;;) {
+        std::unordered_map<Id, std::future<Result>> workers;
+        {
+            std::lock_guard lock{m_mutex};
+            for (auto& [_, channel] : m_channels) channel->Close();
+            workers.swap(m_workers);
+        }
+        if (workers.empty()) break;
+        for (auto& [_, worker] : workers) worker.wait();
+    }
+    std::lock_guard lock{m_mutex};
+    m_channels.clear();
+}
+
+}  // namespace popl::runtime
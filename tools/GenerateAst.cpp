@@ -167,20 +167,46 @@ int main(int argc, char** argv) {
                     "std::vector<std::unique_ptr<{}>> "
                     "arguments",
                     exprBaseName, exprBaseName, exprBaseName),
-        std::format("Variable{}: Token name, std::optional<int> depth",
+        std::format("Variable{}: Token name, std::optional<int> depth, "
+                    "std::optional<int> upvalue",
                     exprBaseName),
         std::format("Logical{}: {}* left, Token op, {}* right", exprBaseName,
                     exprBaseName, exprBaseName),
         std::format("Function{}: std::vector<Token> params, "
-                    "std::vector<std::unique_ptr<{}>> body",
+                    "std::vector<std::unique_ptr<{}>> body, "
+                    "std::vector<Upvalue> upvalues",
                     exprBaseName, stmtBaseName),
         std::format("Get{}: {}* object, Token name", exprBaseName,
                     exprBaseName),
-        std::format("Assign{}: Token name, {}* value, std::optional<int> depth",
+        std::format("Assign{}: Token name, {}* value, "
+                    "std::optional<int> depth, std::optional<int> upvalue",
                     exprBaseName, exprBaseName),
         std::format("Set{}: {}* object, Token name, {}* value", exprBaseName,
                     exprBaseName, exprBaseName),
-        std::format("This{}: Token Keyword, std::optional<int> depth",
+        std::format("This{}: Token Keyword, std::optional<int> depth, "
+                    "std::optional<int> upvalue",
+                    exprBaseName),
+        std::format("Array{}: Token bracket, "
+                    "std::vector<std::unique_ptr<{}>> elements",
+                    exprBaseName, exprBaseName),
+        std::format("Index{}: {}* object, Token bracket, {}* index",
+                    exprBaseName, exprBaseName, exprBaseName),
+        std::format("IndexSet{}: {}* object, Token bracket, {}* index, "
+                    "{}* value",
+                    exprBaseName, exprBaseName, exprBaseName, exprBaseName),
+        std::format("Map{}: Token brace, "
+                    "std::vector<std::unique_ptr<{}>> keys, "
+                    "std::vector<std::unique_ptr<{}>> values",
+                    exprBaseName, exprBaseName, exprBaseName),
+        std::format("Increment{}: Token name, Token op, double constant, "
+                    "std::optional<int> depth, std::optional<int> upvalue",
+                    exprBaseName),
+        std::format("Compare{}: Variable{} left, Token op, "
+                    "std::optional<Variable{}> right, double constant",
+                    exprBaseName, exprBaseName, exprBaseName),
+        std::format("ThisGet{}: This{} object, Token name", exprBaseName,
+                    exprBaseName),
+        std::format("Invariant{}: {}* expression, int slot", exprBaseName,
                     exprBaseName),
     };
 
@@ -192,8 +218,8 @@ int main(int argc, char** argv) {
                     exprBaseName),
         std::format("If{}: {}* condition, {}* thenBranch, {}* elseBranch",
                     stmtBaseName, exprBaseName, stmtBaseName, stmtBaseName),
-        std::format("While{}: {}* condition, {}* body", stmtBaseName,
-                    exprBaseName, stmtBaseName),
+        std::format("While{}: {}* condition, {}* body, int invariants",
+                    stmtBaseName, exprBaseName, stmtBaseName),
         std::format("Break{}: Token keyword", stmtBaseName),
         std::format("Continue{}: Token keyword", stmtBaseName),
         std::format("Function{}: Token name, std::unique_ptr<Function{}> func",